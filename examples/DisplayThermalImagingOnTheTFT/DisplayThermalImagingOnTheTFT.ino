@@ -33,16 +33,42 @@ BMD58T280 TFTscreen(&SPI);    // Create LCD objects
                                             //it is considered as invalid thermal imaging and will not be displayed,(unit:℃)
 #define BackgroundConfig 20                 //Background removal degree,The larger the value, the smaller the transition layer
                                             // between the target and the background. The empirical value is 20 and the range is 0-255
+#define NeighborsConfig  Neighbors4         //Background removal neighbourhood, Optional: Neighbors4/Neighbors8
 #define ColorBarConfig  Rainbow2_65K        //Display style,  Optional:
                                             //PseudoColor1_65K/PseudoColor2_65K/MetalColor1_65K/MetalColor2_65K/Rainbow1_65K/Rainbow2_65K
+#define KernelConfig    KernelBilinear      //Interpolation kernel, Optional: KernelBilinear/KernelBicubic/KernelEdge
+#define OtusTrackerConfig 1                 //1: update the Otus threshold from the pixels that changed (about 800 bytes of RAM), 0: recount every frame
+#define AgcConfig        0                  //Automatic gain control, 0: off, Optional: AgcSmoothRange/AgcEqualize/AgcSmoothRange|AgcEqualize
+#define AlarmTempConfig  0                  //Pixels at or above this temperature are drawn white, 0: off (unit:℃)
+#define SuperResConfig   1                  //Super-resolution grid cells per sensor pixel, 1: off, 2: accumulate frames into a 16*16 grid
+#define BenchmarkConfig  0                  //1:print the imaging algorithm benchmark on the serial port at startup
 /* Global variables ---------------------------------------------------------------------------------------*/
 ThermalImagingConfig ThermImaConfig;
+InterpEngine ScaleEngine;                     //Interpolation engine prepared for the output geometry
+#if KernelConfig == KernelBicubic
+InterpWeights ScaleWeights;                   //Weight table of the bicubic kernel
+#define ScaleWeightsPtr &ScaleWeights
+#else
+#define ScaleWeightsPtr NULL
+#endif
+#if OtusTrackerConfig
+OtusTracker ThresholdTracker;                 //Otus threshold updated from frame to frame
+#endif
+#if AgcConfig != 0
+AutoGain ColorGain;                           //Smoothed range and equalization of the colour scale
+#endif
+#if AlarmTempConfig > 0
+IsothermOverlay AlarmOverlay;                 //Alarm band marked on the image while it is produced
+#endif
 BMS26M833 amg(22,&Wire1);//22:STATUS1
 
 float TempMat[8 * 8];                         //Store temperature data from the sensor
-uint8_t  DataBuf[OutMatWidth * OutMatHeight]; //Store temperature data After algorithm processing
+#if SuperResConfig > 1
+SuperResolution SuperRes;                     //Multi-frame super-resolution stage
+float SuperResMat[8 * SuperResConfig * 8 * SuperResConfig]; //Super-resolved temperature data fed to the imaging algorithm
+#endif
+uint16_t RowBuf[OutMatWidth];                 //One RGB565 output row of the algorithm, pushed to the screen as soon as it is produced
 uint16_t timecnt=0;
-float TempMax,TempMin;                        //temperature maximum data from the sensor
 char AxisPrintout[20];   // char array to print to the screen
 uint16_t maging_xStart,maging_yStart;
 uint32_t Systime = 0;
@@ -59,32 +85,72 @@ void setup() {
   ThermImaConfig.InWidth    = 8;
   ThermImaConfig.InHeight   = 8;  
   ThermImaConfig.InMat      = TempMat;
-  ThermImaConfig.OutMat     = DataBuf;
+#if SuperResConfig > 1
+  if(SuperResInit(&SuperRes,8,8,SuperResConfig,3) == 0)
+  {
+    ThermImaConfig.InWidth  = 8 * SuperResConfig;
+    ThermImaConfig.InHeight = 8 * SuperResConfig;
+    ThermImaConfig.InMat    = SuperResMat;
+  }
+#endif
+  ThermImaConfig.OutMat     = RowBuf;
+  ThermImaConfig.PixelFormat = PixelRGB565;
+  ThermImaConfig.Palette    = ColorBarConfig;
+  ThermImaConfig.Tracker    = NULL;
+#if OtusTrackerConfig
+  OtusTrackerInit(&ThresholdTracker);
+  ThermImaConfig.Tracker    = &ThresholdTracker;
+#endif
+  ThermImaConfig.Gain       = NULL;
+#if AgcConfig != 0
+  AutoGainInit(&ColorGain,AgcConfig,3,16);
+  ThermImaConfig.Gain       = &ColorGain;
+#endif
+  ThermImaConfig.Overlay    = NULL;
+#if AlarmTempConfig > 0
+  AlarmOverlay.Count = 1;
+  AlarmOverlay.Band[0].TempLow  = AlarmTempConfig;
+  AlarmOverlay.Band[0].TempHigh = 1000;
+  AlarmOverlay.Band[0].Color    = 0xFFFF;
+  AlarmOverlay.Band[0].Gray     = 255;
+  ThermImaConfig.Overlay    = &AlarmOverlay;
+#endif
   ThermImaConfig.OutWidth   = OutMatWidth;
   ThermImaConfig.OutHeight  = OutMatHeight;
   ThermImaConfig.Background = BackgroundConfig;
+  ThermImaConfig.Neighbors  = NeighborsConfig;
   ThermImaConfig.TempDiff   = TempDiffConfig;
+  ThermImaConfig.Table      = NULL;
+  ThermImaConfig.Engine     = NULL;
+  if(InterpInit(&ScaleEngine,KernelConfig,ScaleWeightsPtr,ThermImaConfig.InWidth,ThermImaConfig.InHeight,OutMatWidth,OutMatHeight) == 0)
+  {
+    ThermImaConfig.Engine   = &ScaleEngine;
+  }
+#if BenchmarkConfig
+  Benchmark();
+#endif
 }
 
 void loop() {
-  amg.readPixelsAndMaximum(TempMat, TempMax, TempMin);//Obtain temperature and maximum value
+  amg.readPixelsAndMaximum(TempMat, ThermImaConfig.TempMax, ThermImaConfig.TempMin);//Obtain temperature and maximum value
+#if SuperResConfig > 1
+  if(ThermImaConfig.InMat == SuperResMat) SuperResUpdate(&SuperRes,TempMat,SuperResMat);
+#endif
 
-  if(TempMin>0 && TempMax<80)
+  if(ThermImaConfig.TempMin>0 && ThermImaConfig.TempMax<80)
   {
-    InfraredThermalImaging(&ThermImaConfig);         //algorithm processing
-    LCDShow(DataBuf,TempMax,TempMin,OutMatWidth,OutMatHeight,TempDiffConfig,Magnification,maging_xStart,maging_yStart); //display
+    LCDShow(ThermImaConfig.TempMax,ThermImaConfig.TempMin,OutMatWidth,OutMatHeight,TempDiffConfig,Magnification,maging_xStart,maging_yStart); //algorithm processing and display
   }
   else
   {
-    LCDShow(DataBuf,0,0,OutMatWidth,OutMatHeight,TempDiffConfig,Magnification,maging_xStart,maging_yStart);    
+    LCDShow(0,0,OutMatWidth,OutMatHeight,TempDiffConfig,Magnification,maging_xStart,maging_yStart);    
     delay(30);
   }
 }
 
 /**********************************************************
-Description: The thermal imaging grayscale image is toned and displayed on the screen.
-Input:     *Buff: Pointer to the first address of the output matrix (value range 0 ~ 255).
-           Max: Maximum value of original temperature matrix.
+Description: Run the imaging algorithm and display the toned thermal image on the screen.
+Input:     Max: Maximum value of original temperature matrix.
            Min: Minimum value of original temperature matrix.
            Width: Thermal imaging width.
            Height: Thermal image height.
@@ -94,13 +160,12 @@ Input:     *Buff: Pointer to the first address of the output matrix (value range
            yStart: Displays the y value in the upper left corner of the image.
 Output:    none
 Return:    none    
-Others:    none
+Others:    The image is streamed row by row by LCDShowRow(), no full frame buffer is kept.
 **********************************************************/
-void LCDShow(uint8_t *Buff,float Max,float Min,uint8_t Width,uint8_t Height,uint8_t TempDiff,uint8_t Mul,uint16_t xStart,uint16_t yStart)
+void LCDShow(float Max,float Min,uint16_t Width,uint16_t Height,uint8_t TempDiff,uint8_t Mul,uint16_t xStart,uint16_t yStart)
 { 
-  uint16_t temp; 
   uint16_t color;
-  uint16_t i,j,k,l,xLeng,yLeng;
+  uint16_t xLeng,yLeng;
   xLeng = Mul * Width;
   yLeng = Mul * Height;
 
@@ -117,19 +182,193 @@ void LCDShow(uint8_t *Buff,float Max,float Min,uint8_t Width,uint8_t Height,uint
     return;
   } 
   TFTscreen.setAddrWindow(xStart,yStart,xLeng,yLeng);
-  for(i = 0;i < Height;i++)
+  InfraredThermalImagingStream(&ThermImaConfig,LCDShowRow,&Mul);
+}
+/**********************************************************
+Description: Push one toned row of the thermal image to the screen.
+Input:     Row: Row index in the thermal image.
+           *RowMat: RGB565 colors of the row, already toned by the imaging algorithm.
+           Width: Thermal imaging width.
+           *Arg: Pointer to the display magnification.
+Output:    none
+Return:    none    
+Others:    Called by InfraredThermalImagingStream() inside the address window set by LCDShow().
+**********************************************************/
+void LCDShowRow(uint16_t Row,void *RowMat,uint16_t Width,void *Arg)
+{
+  uint16_t *Color = (uint16_t *)RowMat;
+  uint8_t Mul = *(uint8_t *)Arg;
+  uint16_t j,k;
+
+  for(k = 0;k < Mul;k++)
   {
-    for(k = 0;k < Mul;k++)
-    {
-      for(j = 0;j < Width;j++)
-      {   
-        temp = i * Width + j;
-        color=ColorBarConfig[Buff[temp]]; 
-        TFTscreen.writeColor(color,Mul);
-      }
+    for(j = 0;j < Width;j++)
+    {   
+      TFTscreen.writeColor(Color[j],Mul);
     }
-  } 
+  }
 }
+#if BenchmarkConfig
+/**********************************************************
+Description: Compare the frame rate of the imaging algorithms and print it on the serial port.
+Input:     none
+Output:    none
+Return:    none    
+Others:    A synthetic gray frame is used so the result does not depend on the scene.
+**********************************************************/
+void Benchmark()
+{
+  const uint16_t Frames = 100;
+  static BilinearTable ScaleTable;
+  static InterpEngine BicubicEngine;
+  static InterpWeights BicubicWeights;
+  static InterpEngine EdgeEngine;
+  static OtusTracker FullTracker;
+  static OtusTracker DeltaTracker;
+  static AutoGain BenchGain;
+  static uint16_t GrayNum[256];
+  static uint16_t ColorBuf[OutMatWidth * OutMatHeight];
+  uint8_t *DataBuf = (uint8_t *)ColorBuf;
+  uint8_t GrayMat[8 * 8];
+  uint16_t i,Mismatch;
+  uint32_t Start,Time;
+
+  for(i = 0;i < 64;i++) GrayMat[i] = (i * 37) & 0xff;
+  BilinearInit(&ScaleTable,8,8,OutMatWidth,OutMatHeight);
+  InterpInit(&BicubicEngine,KernelBicubic,&BicubicWeights,8,8,OutMatWidth,OutMatHeight);
+  InterpInit(&EdgeEngine,KernelEdge,NULL,8,8,OutMatWidth,OutMatHeight);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) Bilinear(GrayMat,DataBuf,8,8,OutMatWidth,OutMatHeight);
+  Time = micros() - Start;
+  Serial.print("Bilinear     FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) BilinearFast(&ScaleTable,GrayMat,DataBuf);
+  Time = micros() - Start;
+  Serial.print("BilinearFast FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InterpRun(&ScaleEngine,GrayMat,DataBuf);
+  Time = micros() - Start;
+  Serial.print("InterpRun    FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InterpRun(&BicubicEngine,GrayMat,DataBuf);
+  Time = micros() - Start;
+  Serial.print("Bicubic      FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InterpRun(&EdgeEngine,GrayMat,DataBuf);
+  Time = micros() - Start;
+  Serial.print("Edge         FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  //Whole pipeline, staged stages against the fused kernel, in CPU cycles per frame
+  for(i = 0;i < 64;i++) TempMat[i] = 20 + ((i * 37) & 63) * 0.25;
+  ThermImaConfig.TempMax = 35.75;
+  ThermImaConfig.TempMin = 20;
+  ThermImaConfig.OutMat = DataBuf;
+  ThermImaConfig.PixelFormat = PixelGray8;
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InfraredThermalImaging(&ThermImaConfig);
+  Time = micros() - Start;
+  Serial.print("Staged pipeline cycles/frame: ");
+  Serial.println((float)Time / Frames * (F_CPU / 1000000));
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InfraredThermalImagingFused(&ThermImaConfig);
+  Time = micros() - Start;
+  Serial.print("Fused pipeline  cycles/frame: ");
+  Serial.println((float)Time / Frames * (F_CPU / 1000000));
+
+  //Automatic gain control: smoothed range with plateau equalization, on top of the fused pipeline
+  AutoGain *Gain = ThermImaConfig.Gain;
+  ThermImaConfig.Gain = &BenchGain;
+  AutoGainInit(&BenchGain,AgcSmoothRange | AgcEqualize,3,16);
+  Start = micros();
+  for(i = 0;i < Frames;i++) InfraredThermalImagingFused(&ThermImaConfig);
+  Time = micros() - Start;
+  Serial.print("Fused with AGC  cycles/frame: ");
+  Serial.println((float)Time / Frames * (F_CPU / 1000000));
+  ThermImaConfig.Gain = Gain;
+
+
+  //Gray output toned in a second pass against the palette fused into interpolation
+  Start = micros();
+  for(i = 0;i < Frames;i++)
+  {
+    InterpRun(&ScaleEngine,GrayMat,DataBuf);
+    //Backwards, so expanding in place never overwrites a gray byte that is still to be read
+    for(uint16_t n = OutMatWidth * OutMatHeight;n-- > 0;) ColorBuf[n] = ColorBarConfig[DataBuf[n]];
+  }
+  Time = micros() - Start;
+  Serial.print("Gray + palette pass FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) InterpRunTileColor(&ScaleEngine,GrayMat,ColorBuf,ColorBarConfig,0,0,OutMatWidth,OutMatHeight);
+  Time = micros() - Start;
+  Serial.print("Direct RGB565       FPS: ");
+  Serial.println(Frames * 1000000.0 / Time);
+
+  //Gray mapping, float divide per pixel against one fixed-point reciprocal per frame
+  static int16_t RawMat[8 * 8];
+  uint8_t FixedMat[8 * 8];
+  for(i = 0;i < 64;i++) RawMat[i] = TempMat[i] * 4;
+  Start = micros();
+  for(i = 0;i < Frames;i++) TransformGray(TempMat,GrayMat,8,8,35.75,20);
+  Time = micros() - Start;
+  Serial.print("TransformGray      us/frame: ");
+  Serial.println((float)Time / Frames);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) TransformGrayFixed(RawMat,FixedMat,8,8,143,80);
+  Time = micros() - Start;
+  Serial.print("TransformGrayFixed us/frame: ");
+  Serial.println((float)Time / Frames);
+  Mismatch = 0;
+  for(i = 0;i < 64;i++) Mismatch += GrayMat[i] != FixedMat[i];
+  Serial.print("TransformGrayFixed mismatches: ");
+  Serial.println(Mismatch);
+
+  //Otus threshold search, exact integer against floating point
+  memset(GrayNum,0,sizeof(GrayNum));
+  for(i = 0;i < 64;i++) GrayNum[GrayMat[i]]++;
+  Start = micros();
+  for(i = 0;i < Frames;i++) OtusHistogram(GrayNum,64);
+  Time = micros() - Start;
+  Serial.print("Otus integer us/frame: ");
+  Serial.println((float)Time / Frames);
+
+  Start = micros();
+  for(i = 0;i < Frames;i++) OtusHistogramFloat(GrayNum,64);
+  Time = micros() - Start;
+  Serial.print("Otus float   us/frame: ");
+  Serial.println((float)Time / Frames);
+
+  //Incremental threshold must match a full recount on a slowly drifting scene
+  OtusTrackerInit(&DeltaTracker);
+  Mismatch = 0;
+  for(i = 0;i < Frames;i++)
+  {
+    GrayMat[(i * 7) & 63] += 3;
+    GrayMat[(i * 13) & 63] -= 5;
+    OtusTrackerInit(&FullTracker);
+    if(OtusTrackerUpdate(&DeltaTracker,GrayMat,8,8) != OtusTrackerUpdate(&FullTracker,GrayMat,8,8)) Mismatch++;
+  }
+  Serial.print("Otus tracker mismatches: ");
+  Serial.println(Mismatch);
+
+  ThermImaConfig.OutMat = RowBuf;
+  ThermImaConfig.PixelFormat = PixelRGB565;
+}
+#endif
 /******************************************************************************
 Description: Displays a two-digit decimal variable
 Input:      x,y： displays coordinates
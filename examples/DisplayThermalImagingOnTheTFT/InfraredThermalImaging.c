@@ -7,28 +7,379 @@ V1.0.1   -- initial version；2021-09-01；Arduino IDE :v1.8.15
 ******************************************************************/
 #include "InfraredThermalImaging.h"
 
-#define MaxGrayscale 256
-extern float TempMax,TempMin;
+/*x86-64 SIMD kernels, see SimdSelect(); other targets compile the scalar code only*/
+#if defined(__x86_64__) || defined(_M_X64)
+#define ThermalSimdX86
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define ThermalSimdAvx2
+#include <immintrin.h>
+#endif
+#endif
 
+#if defined(ThermalSimdX86)
+/*Instruction set in effect, shared by every configuration: read and written as one 
+  atomic byte so concurrent pipelines may select it lazily*/
+static uint8_t SimdLevel = SimdAuto;
+#if defined(__GNUC__)
+#define SimdLevelLoad()       __atomic_load_n(&SimdLevel,__ATOMIC_RELAXED)
+#define SimdLevelStore(Level) __atomic_store_n(&SimdLevel,(Level),__ATOMIC_RELAXED)
+#else
+#define SimdLevelLoad()       (*(volatile uint8_t *)&SimdLevel)
+#define SimdLevelStore(Level) (*(volatile uint8_t *)&SimdLevel = (Level))
+#endif
+#endif
+
+static uint8_t Interpolate(ThermalImagingConfig *Config,uint8_t *TempGrayMat);
+static uint8_t EngineMatches(ThermalImagingConfig *Config);
+static uint8_t OtusSearch(uint16_t *GrayNum,uint16_t TotalPixels,uint32_t TotalSum,const uint32_t *Occupied);
+static uint8_t LowestBit(uint32_t Bits);
+static uint8_t InterpRows(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutGray,uint16_t *OutColor,const unsigned int *Palette,const uint8_t *GrayMap,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight);
+static uint8_t RenderRows(ThermalImagingConfig *Config,uint8_t *GrayMat,void *OutMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight);
+#if defined(ThermalSimdX86)
+static uint8_t SimdCurrent(void);
+#endif
+static uint32_t SimdGrayFloat(float *InMat,uint8_t *OutMat,uint32_t Total,float Min,float SubValue);
+static uint32_t SimdGrayFixed(int16_t *InMat,uint8_t *OutMat,uint32_t Total,int16_t Max,int16_t Min,uint32_t Scale);
+static uint32_t SimdDecode(uint8_t *Bytes,int16_t *RawMat,uint32_t Pixels);
+static uint32_t SimdBilinearCols(int32_t *Row,uint32_t fx,uint32_t Step,uint16_t Width,uint8_t *OutGray,uint16_t *OutColor,const unsigned int *Palette);
+static uint32_t SimdPalette(uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint32_t Pixels);
+
+ /**********************************************************
+Description: Convert temperature matrix to the gray matrix that is fed to interpolation.
+Input:       *Config: Configuration structure.        
+             *GrayMat: InWidth * InHeight gray matrix to be filled.
+Output:      none 
+Return:      0: gray matrix ready  1: temperature difference too small, nothing to display    
+Others:      none
+**********************************************************/
+static uint8_t PrepareGray(ThermalImagingConfig *Config,uint8_t *GrayMat)
+{
+  uint8_t Threshold;
+  float sub = 0;
+  
+  TransformGray(Config -> InMat,GrayMat,Config -> InWidth,Config -> InHeight,Config -> TempMax,Config -> TempMin);
+  sub= Config -> TempMax - Config -> TempMin;
+  if(sub <= Config -> TempDiff) return 1;
+  Threshold = Otus(GrayMat,Config -> InWidth,Config -> InHeight);
+  BackgroundFiltering(GrayMat,Config -> InWidth,Config -> InHeight,Threshold,Config -> Background);
+  if(Config -> Overlay != NULL)
+  {
+    IsothermBuild(Config -> Overlay,Config -> PixelFormat,Config -> Palette,Config -> TempMax,Config -> TempMin,NULL);
+  }
+  return 0;
+}
+ /**********************************************************
+Description: Fused version of PrepareGray().
+Input:       *Config: Configuration structure.        
+             *GrayMat: InWidth * InHeight gray matrix to be filled.
+Output:      none 
+Return:      0: gray matrix ready  1: temperature difference too small, nothing to display    
+Others:      The gray transform multiplies by one reciprocal instead of dividing 
+             every pixel, and counts the Otus histogram in the same pass, so the 
+             image is walked once before filtering instead of twice.
+             With Config -> Gain the mapped range is the smoothed one, and the 
+             equalization curve is built from the same histogram and applied 
+             after background suppression, which keeps 0 at 0.
+             With Config -> Overlay the isotherm tables of the frame are built 
+             from the same range and curve.
+**********************************************************/
+static uint8_t PrepareGrayFused(ThermalImagingConfig *Config,uint8_t *GrayMat)
+{
+  uint16_t GrayNum[MaxGrayscale] = {0};
+  uint16_t Num,Total;
+  uint8_t Threshold,Equalized;
+  float Scale,Value,Max,Min;
+
+  if(Config -> TempMax - Config -> TempMin <= Config -> TempDiff) return 1;
+  Max = Config -> TempMax;
+  Min = Config -> TempMin;
+  if(Config -> Gain != NULL) AutoGainRange(Config -> Gain,&Max,&Min);
+  Scale = 255 / (Max - Min);
+  Total = Config -> InWidth * Config -> InHeight;
+  for(Num = 0;Num < Total;Num++)
+  {
+    //The small bias keeps exact quotients of 0.25 degC steps from truncating one level low
+    Value = (Config -> InMat[Num] - Min) * Scale + (float)0.001;
+    GrayMat[Num] = Value <= 0 ? 0 : (Value >= 255 ? 255 : Value);
+    GrayNum[GrayMat[Num]]++;
+  }
+  if(Config -> Tracker != NULL) Threshold = OtusTrackerUpdate(Config -> Tracker,GrayMat,Config -> InWidth,Config -> InHeight);
+  else                          Threshold = OtusHistogram(GrayNum,Total);
+  BackgroundSuppress(GrayMat,GrayMat,Config -> InWidth,Config -> InHeight,Threshold,Config -> Background,
+                     Config -> Neighbors == Neighbors8 ? Neighbors8 : Neighbors4);
+  Equalized = Config -> Gain != NULL && AutoGainEqualize(Config -> Gain,GrayNum,Total) == 0;
+  if(Equalized)
+  {
+    for(Num = 0;Num < Total;Num++) GrayMat[Num] = Config -> Gain -> Lut[GrayMat[Num]];
+  }
+  if(Config -> Overlay != NULL)
+  {
+    IsothermBuild(Config -> Overlay,Config -> PixelFormat,Config -> Palette,Max,Min,Equalized ? Config -> Gain -> Lut : NULL);
+  }
+  return 0;
+}
  /**********************************************************
 Description: Convert temperature matrix to thermal imaging.
 Input:       *Config: Configuration structure.        
 Output:      none 
-Return:      none    
+Return:      0: success or temperature difference too small  
+             1: PixelRGB565 without a palette or a matching engine    
 Others:      none
 **********************************************************/
 uint8_t InfraredThermalImaging(ThermalImagingConfig *Config)
 {
-  uint8_t Threshold;
   uint8_t TempGrayMat[Config -> InWidth * Config -> InHeight];
-  float sub = 0;
   
-  TransformGray(Config -> InMat,TempGrayMat,Config -> InWidth,Config -> InHeight,TempMax,TempMin);
-  sub= TempMax - TempMin;
-  if(sub <= Config -> TempDiff) return 0;
-  Threshold = Otus(TempGrayMat,Config -> InWidth,Config -> InHeight);
-  BackgroundFiltering(TempGrayMat,Config -> InWidth,Config -> InHeight,Threshold,Config -> Background);
-  Bilinear(TempGrayMat,Config -> OutMat,Config -> InWidth,Config -> InHeight,Config -> OutWidth,Config -> OutHeight);
+  if(Config -> PixelFormat == PixelRGB565 && Config -> Palette == NULL) return 1;
+  if(PrepareGray(Config,TempGrayMat) != 0) return 0;
+  return Interpolate(Config,TempGrayMat);
+}
+ /**********************************************************
+Description: Convert temperature matrix to thermal imaging with the fused pipeline.
+Input:       *Config: Configuration structure.        
+Output:      none 
+Return:      0: success  1: InWidth * InHeight exceeds MaxInPixels, or PixelRGB565 
+             without a palette or a matching engine    
+Others:      Same result as InfraredThermalImaging() for the 0.25 degC sensor 
+             data, see PrepareGrayFused().
+**********************************************************/
+uint8_t InfraredThermalImagingFused(ThermalImagingConfig *Config)
+{
+  uint8_t TempGrayMat[MaxInPixels];
+
+  if((uint32_t)Config -> InWidth * Config -> InHeight > MaxInPixels) return 1;
+  if(Config -> PixelFormat == PixelRGB565 && Config -> Palette == NULL) return 1;
+  if(PrepareGrayFused(Config,TempGrayMat) != 0) return 0;
+  return Interpolate(Config,TempGrayMat);
+}
+ /**********************************************************
+Description: Interpolate the gray matrix into Config -> OutMat.
+Input:       *Config: Configuration structure.        
+             *GrayMat: InWidth * InHeight gray matrix.
+Output:      none 
+Return:      0: success  1: PixelRGB565 requested without a palette or a matching engine    
+Others:      Uses Config -> Engine, then Config -> Table, then Bilinear(), 
+             whichever is first available for the configured geometry. 
+             RGB565 output is only produced by the engine.
+**********************************************************/
+static uint8_t Interpolate(ThermalImagingConfig *Config,uint8_t *TempGrayMat)
+{
+  uint32_t Num;
+
+  if(EngineMatches(Config))
+  {
+    return RenderRows(Config,TempGrayMat,Config -> OutMat,0,0,Config -> OutWidth,Config -> OutHeight);
+  }
+  if(Config -> PixelFormat == PixelRGB565) return 1;
+  if(Config -> Table != NULL &&
+     Config -> Table -> InWidth   == Config -> InWidth  && Config -> Table -> InHeight  == Config -> InHeight &&
+     Config -> Table -> OutWidth  == Config -> OutWidth && Config -> Table -> OutHeight == Config -> OutHeight)
+  {
+    BilinearFast(Config -> Table,TempGrayMat,Config -> OutMat);
+  }
+  else
+  {
+    Bilinear(TempGrayMat,Config -> OutMat,Config -> InWidth,Config -> InHeight,Config -> OutWidth,Config -> OutHeight);
+  }
+  if(Config -> Overlay != NULL && Config -> Overlay -> Count != 0)
+  {
+    //Only the engine marks the bands while producing the pixels, the other paths need a second pass
+    for(Num = 0;Num < (uint32_t)Config -> OutWidth * Config -> OutHeight;Num++)
+    {
+      ((uint8_t *)Config -> OutMat)[Num] = Config -> Overlay -> GrayMap[((uint8_t *)Config -> OutMat)[Num]];
+    }
+  }
+  return 0;
+}
+ /**********************************************************
+Description: Check that Config -> Engine is prepared for the geometry of the configuration.
+Input:       *Config: Configuration structure.        
+Output:      none 
+Return:      1: engine set for InWidth * InHeight -> OutWidth * OutHeight  0: otherwise    
+Others:      The engine reads its own geometry, so an engine prepared for a 
+             larger input would read past the gray matrix of the frame.
+**********************************************************/
+static uint8_t EngineMatches(ThermalImagingConfig *Config)
+{
+  return Config -> Engine != NULL &&
+         Config -> Engine -> InWidth  == Config -> InWidth  && Config -> Engine -> InHeight  == Config -> InHeight &&
+         Config -> Engine -> OutWidth == Config -> OutWidth && Config -> Engine -> OutHeight == Config -> OutHeight;
+}
+ /**********************************************************
+Description: Interpolate a tile of the gray matrix in the output format of the configuration.
+Input:       *Config: Configuration structure, Config -> Engine must match its geometry.
+             *GrayMat: InWidth * InHeight gray matrix.
+             *OutMat: TileWidth * TileHeight output pixels.
+             xStart,yStart,TileWidth,TileHeight: Tile of the output image.
+Output:      none 
+Return:      0: success  1: tile outside the output image or PixelRGB565 without a palette    
+Others:      With an isotherm overlay the bands come from the palette (RGB565) 
+             or the gray mapping built for the frame, at no cost per pixel 
+             beyond the table lookup.
+**********************************************************/
+static uint8_t RenderRows(ThermalImagingConfig *Config,uint8_t *GrayMat,void *OutMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight)
+{
+  uint8_t Marked = Config -> Overlay != NULL && Config -> Overlay -> Count != 0;
+
+  if(Config -> PixelFormat == PixelRGB565)
+  {
+    if(Config -> Palette == NULL) return 1;
+    return InterpRows(Config -> Engine,GrayMat,NULL,(uint16_t *)OutMat,Marked ? Config -> Overlay -> Palette : Config -> Palette,NULL,
+                      xStart,yStart,TileWidth,TileHeight);
+  }
+  return InterpRows(Config -> Engine,GrayMat,(uint8_t *)OutMat,NULL,NULL,Marked ? Config -> Overlay -> GrayMap : NULL,
+                    xStart,yStart,TileWidth,TileHeight);
+}
+ /**********************************************************
+Description: Convert temperature matrix to thermal imaging, one output row at a time.
+Input:       *Config: Configuration structure, Config -> Engine must be prepared 
+                      for InWidth * InHeight -> OutWidth * OutHeight and 
+                      Config -> OutMat must hold one output row (OutWidth bytes, 
+                      OutWidth * 2 bytes in PixelRGB565).
+             Sink: Called for every output row, from top to bottom.
+             *Arg: User argument passed to Sink.
+Output:      none 
+Return:      0: image emitted  1: no matching engine, geometry too large, or 
+             PixelRGB565 without a palette  2: temperature difference too small, 
+             Sink not called    
+Others:      No full-size output buffer is needed, so a display driver can 
+             push each row to the screen as soon as it is produced.
+**********************************************************/
+uint8_t InfraredThermalImagingStream(ThermalImagingConfig *Config,ThermalImagingRowSink Sink,void *Arg)
+{
+  uint8_t TempGrayMat[MaxInPixels];
+  uint16_t row;
+
+  if(!EngineMatches(Config) || (uint32_t)Config -> InWidth * Config -> InHeight > MaxInPixels) return 1;
+  if(Config -> PixelFormat == PixelRGB565 && Config -> Palette == NULL) return 1;
+  if(PrepareGrayFused(Config,TempGrayMat) != 0) return 2;
+  for(row = 0;row < Config -> OutHeight;row++)
+  {
+    RenderRows(Config,TempGrayMat,Config -> OutMat,0,row,Config -> OutWidth,1);
+    Sink(row,Config -> OutMat,Config -> OutWidth,Arg);
+  }
+  return 0;
+}
+ /**********************************************************
+Description: Prepare the gray matrix of a frame for InfraredThermalImagingTile().
+Input:       *Config: Configuration structure.
+             *GrayMat: MaxInPixels gray matrix to be filled, kept by the caller 
+                       while the tiles of the frame are rendered.
+Output:      none 
+Return:      0: gray matrix ready  1: InWidth * InHeight exceeds MaxInPixels, or 
+             PixelRGB565 without a palette  2: temperature difference too small, 
+             nothing to display    
+Others:      Runs the fused pipeline once per frame, so the automatic gain, 
+             the threshold tracker and the isotherm tables advance once per 
+             frame however many tiles are rendered from it.
+**********************************************************/
+uint8_t InfraredThermalImagingPrepare(ThermalImagingConfig *Config,uint8_t *GrayMat)
+{
+  if((uint32_t)Config -> InWidth * Config -> InHeight > MaxInPixels) return 1;
+  if(Config -> PixelFormat == PixelRGB565 && Config -> Palette == NULL) return 1;
+  if(PrepareGrayFused(Config,GrayMat) != 0) return 2;
+  return 0;
+}
+ /**********************************************************
+Description: Convert a prepared frame to one rectangular tile of the thermal image.
+Input:       *Config: Configuration structure, Config -> Engine must be prepared 
+                      for InWidth * InHeight -> OutWidth * OutHeight.
+             *GrayMat: Gray matrix of the frame from InfraredThermalImagingPrepare().
+             xStart: Left column of the tile in the output image.
+             yStart: Top row of the tile in the output image.
+             TileWidth: Tile width.
+             TileHeight: Tile height.
+Output:      Config -> OutMat: TileWidth * TileHeight pixels of the tile, 1 byte each 
+                               (PixelGray8) or 2 bytes each (PixelRGB565).
+Return:      0: success  1: no matching engine, tile outside the output image or 
+             PixelRGB565 without a palette    
+Others:      Large targets (e.g. 320 * 240 or 640 * 640) can be rendered tile 
+             by tile into a small buffer instead of one full-size OutMat. 
+             Only interpolation runs per tile, the tiles of one prepared frame 
+             join without seams.
+**********************************************************/
+uint8_t InfraredThermalImagingTile(ThermalImagingConfig *Config,uint8_t *GrayMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight)
+{
+  if(!EngineMatches(Config)) return 1;
+  return RenderRows(Config,GrayMat,Config -> OutMat,xStart,yStart,TileWidth,TileHeight);
+}
+ /**********************************************************
+Description: Convert the frames of several sensors to thermal images in one pass.
+Input:       *Batch: Batch structure, Batch -> Engine must be prepared 
+                     for InWidth * InHeight -> OutWidth * OutHeight.
+Output:      Batch -> OutMat: Frames output matrices, frame after frame.
+             Batch -> Status: Result of every frame, if not NULL.
+Return:      0: success  1: no matching engine, geometry too large or RGB565 without palette    
+Others:      The frames are taken BatchGroup at a time: their gray matrices are 
+             prepared with the fused pipeline, then the output is produced in 
+             bands of BatchBandRows rows, the same band of every frame in turn, 
+             so the engine and the gray matrices of the group stay in cache 
+             while each output is written once, in order. Every frame gets 
+             the same bytes as InfraredThermalImagingFused() with the same 
+             settings; a frame whose temperature difference is too small is 
+             left untouched.
+**********************************************************/
+uint8_t InfraredThermalImagingBatch(ThermalImagingBatch *Batch)
+{
+  uint8_t GrayMat[BatchGroup][MaxInPixels];
+  uint8_t Ready[BatchGroup];
+  ThermalImagingConfig Config;
+  uint32_t InPixels,OutPixels,Frame;
+  uint16_t Group,k,Band,Rows;
+
+  InPixels  = (uint32_t)Batch -> InWidth * Batch -> InHeight;
+  OutPixels = (uint32_t)Batch -> OutWidth * Batch -> OutHeight;
+  if(Batch -> Engine == NULL || InPixels > MaxInPixels) return 1;
+  if(Batch -> Engine -> InWidth != Batch -> InWidth || Batch -> Engine -> InHeight != Batch -> InHeight ||
+     Batch -> Engine -> OutWidth != Batch -> OutWidth || Batch -> Engine -> OutHeight != Batch -> OutHeight) return 1;
+  if(Batch -> PixelFormat == PixelRGB565 && Batch -> Palette == NULL) return 1;
+  memset(&Config,0,sizeof(Config));
+  Config.InWidth    = Batch -> InWidth;
+  Config.InHeight   = Batch -> InHeight;
+  Config.OutWidth   = Batch -> OutWidth;
+  Config.OutHeight  = Batch -> OutHeight;
+  Config.Background = Batch -> Background;
+  Config.Neighbors  = Batch -> Neighbors;
+  Config.TempDiff   = Batch -> TempDiff;
+  Config.PixelFormat = Batch -> PixelFormat;
+  Config.Palette    = Batch -> Palette;
+  Config.Engine     = Batch -> Engine;
+
+  for(Frame = 0;Frame < Batch -> Frames;Frame += Group)
+  {
+    Group = Batch -> Frames - Frame < BatchGroup ? Batch -> Frames - Frame : BatchGroup;
+    for(k = 0;k < Group;k++)
+    {
+      Config.InMat   = Batch -> InMat + (Frame + k) * InPixels;
+      Config.TempMax = Batch -> TempMax[Frame + k];
+      Config.TempMin = Batch -> TempMin[Frame + k];
+      Config.Tracker = Batch -> Tracker == NULL ? NULL : Batch -> Tracker + Frame + k;
+      Config.Gain    = Batch -> Gain    == NULL ? NULL : Batch -> Gain    + Frame + k;
+      Config.Overlay = Batch -> Overlay == NULL ? NULL : Batch -> Overlay + Frame + k;
+      Ready[k] = PrepareGrayFused(&Config,GrayMat[k]) == 0;
+      if(Batch -> Status != NULL) Batch -> Status[Frame + k] = !Ready[k];
+    }
+    for(Band = 0;Band < Batch -> OutHeight;Band += Rows)
+    {
+      Rows = Batch -> OutHeight - Band < BatchBandRows ? Batch -> OutHeight - Band : BatchBandRows;
+      for(k = 0;k < Group;k++)
+      {
+        if(!Ready[k]) continue;
+        Config.Overlay = Batch -> Overlay == NULL ? NULL : Batch -> Overlay + Frame + k;
+        if(Batch -> PixelFormat == PixelRGB565)
+        {
+          RenderRows(&Config,GrayMat[k],(uint16_t *)Batch -> OutMat + (Frame + k) * OutPixels + (uint32_t)Band * Batch -> OutWidth,
+                     0,Band,Batch -> OutWidth,Rows);
+        }
+        else
+        {
+          RenderRows(&Config,GrayMat[k],(uint8_t *)Batch -> OutMat + (Frame + k) * OutPixels + (uint32_t)Band * Batch -> OutWidth,
+                     0,Band,Batch -> OutWidth,Rows);
+        }
+      }
+    }
+  }
   return 0;
 }
 /**********************************************************
@@ -43,7 +394,7 @@ Output:      none
 Return:      none    
 Others:      none
 **********************************************************/
-uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight,uint8_t OutWidth,uint8_t OutHeight)
+uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight)
 {
   unsigned short row ,col;
   float fy,fx,RowFactor,ColFactor;
@@ -77,7 +428,7 @@ uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight
       //Enlarge the floating-point number to make integer operation become floating-point operation
       xbuf[0] = ((float)1.0 - fx) * 2048;
       xbuf[1] = 2048 - xbuf[0];
-      OutMat[row * OutWidth + col] = (InMat[ sy      * InWidth + sx]     * ybuf[0] * xbuf[0] +
+      OutMat[(uint32_t)row * OutWidth + col] = (InMat[ sy      * InWidth + sx]     * ybuf[0] * xbuf[0] +
                                       InMat[(sy + 1) * InWidth + sx]     * ybuf[1] * xbuf[0] +
                                       InMat[ sy      * InWidth + (sx+1)] * ybuf[0] * xbuf[1] +
                                       InMat[(sy + 1) * InWidth + (sx+1)] * ybuf[1] * xbuf[1] ) >> 22; 
@@ -86,6 +437,354 @@ uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight
   return 0;
 }
 /**********************************************************
+Description: Precompute the bilinear interpolation tables for one geometry.
+Input:       *Table: Table object to be filled.
+             InWidth: Original image width.
+             InHeight: Original image height.
+             OutWidth: Output image width (at most MaxOutSize).
+             OutHeight: Output image height (at most MaxOutSize).
+Output:      *Table: Source index and 2048-scaled weight of every output row and column.
+Return:      0: success  1: geometry exceeds MaxOutSize
+Others:      The coordinate mapping is the same as Bilinear(), so BilinearFast() 
+             produces identical output.
+**********************************************************/
+uint8_t BilinearInit(BilinearTable *Table,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight)
+{
+  unsigned short row ,col;
+  float fy,fx,RowFactor,ColFactor;
+  unsigned short sy ,sx;
+
+  if(OutWidth > MaxOutSize || OutHeight > MaxOutSize) return 1;
+  Table -> InWidth   = InWidth;
+  Table -> InHeight  = InHeight;
+  Table -> OutWidth  = OutWidth;
+  Table -> OutHeight = OutHeight;
+
+  RowFactor = (float)(InHeight - 1) / OutHeight;
+  ColFactor = (float)(InWidth  - 1) / OutWidth;
+  for(row = 0;row < OutHeight;row++)
+  {
+    fy = (row + (float)0.5) * RowFactor;
+    sy = fy;
+    fy -= sy;
+    if(fy < 0) fy = 0;
+    Table -> RowIndex[row]  = sy;
+    Table -> RowWeight[row] = ((float)1.0 - fy) * 2048;
+  }
+  for(col = 0;col < OutWidth;col++)
+  {
+    fx = (col + (float)0.5) * ColFactor;
+    sx = fx;
+    fx -= sx;
+    if(fx < 0) fx = 0;
+    Table -> ColIndex[col]  = sx;
+    Table -> ColWeight[col] = ((float)1.0 - fx) * 2048;
+  }
+  return 0;
+}
+/**********************************************************
+Description: Bilinear interpolation of gray image using precomputed tables.
+Input:       *Table: Tables prepared by BilinearInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *OutMat: Pointer to the first address of the output matrix (value range 0 ~ 255).      
+Output:      none 
+Return:      none    
+Others:      Integer-only inner loop, no floating point per pixel.
+**********************************************************/
+uint8_t BilinearFast(BilinearTable *Table,uint8_t *InMat,uint8_t *OutMat)
+{
+  unsigned short row ,col;
+  uint8_t *Line0,*Line1;
+  uint16_t sx,y0,y1,x0;
+  uint32_t Left,Right;
+
+  for(row = 0;row < Table -> OutHeight;row++)
+  {
+    y0 = Table -> RowWeight[row];
+    y1 = 2048 - y0;
+    Line0 = InMat + (uint32_t)Table -> RowIndex[row] * Table -> InWidth;
+    Line1 = Line0 + Table -> InWidth;
+    for(col = 0;col < Table -> OutWidth;col++)
+    {
+      sx = Table -> ColIndex[col];
+      x0 = Table -> ColWeight[col];
+      Left  = (uint32_t)Line0[sx]     * y0 + (uint32_t)Line1[sx]     * y1;
+      Right = (uint32_t)Line0[sx + 1] * y0 + (uint32_t)Line1[sx + 1] * y1;
+      *OutMat++ = (Left * x0 + Right * (2048 - x0)) >> 22;
+    }
+  }
+  return 0;
+}
+/**********************************************************
+Description: Prepare the separable interpolation engine for one geometry and kernel.
+Input:       *Engine: Engine object to be initialized.
+             Kernel: KernelBilinear, KernelBicubic (Catmull-Rom) or KernelEdge (edge-directed).
+             *Weights: Weight table filled for KernelBicubic and kept by the engine, 
+                       NULL for the other kernels.
+             InWidth: Original image width (at most MaxInWidth).
+             InHeight: Original image height.
+             OutWidth: Output image width.
+             OutHeight: Output image height.
+Output:      *Engine: Coordinate steps and kernel.
+             *Weights: Bicubic weights of every sub-pixel phase.
+Return:      0: success  1: unsupported geometry or kernel, or KernelBicubic without Weights
+Others:      The coordinate mapping is the same as Bilinear().
+**********************************************************/
+uint8_t InterpInit(InterpEngine *Engine,uint8_t Kernel,InterpWeights *Weights,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight)
+{
+  uint8_t Phase;
+  float t,t2,t3;
+
+  if(InWidth > MaxInWidth || InWidth < 2 || InHeight < 2 || OutWidth == 0 || OutHeight == 0) return 1;
+  if(Kernel != KernelBilinear && Kernel != KernelBicubic && Kernel != KernelEdge) return 1;
+  if(Kernel == KernelBicubic && Weights == NULL) return 1;
+  Engine -> Kernel    = Kernel;
+  Engine -> Weights   = Kernel == KernelBicubic ? Weights : NULL;
+  Engine -> InWidth   = InWidth;
+  Engine -> InHeight  = InHeight;
+  Engine -> OutWidth  = OutWidth;
+  Engine -> OutHeight = OutHeight;
+
+  //Output pixel n maps to source coordinate (n + 0.5) * (In - 1) / Out
+  Engine -> ColStep  = ((uint32_t)(InWidth  - 1) << 16) / OutWidth;
+  Engine -> ColStart = Engine -> ColStep >> 1;
+  Engine -> RowStep  = ((uint32_t)(InHeight - 1) << 16) / OutHeight;
+  Engine -> RowStart = Engine -> RowStep >> 1;
+
+  //Catmull-Rom weights of the taps at -1, 0, +1, +2, the center tap absorbs the rounding error
+  if(Kernel != KernelBicubic) return 0;
+  for(Phase = 0;Phase < InterpPhases;Phase++)
+  {
+    t  = (float)Phase / InterpPhases;
+    t2 = t * t;
+    t3 = t2 * t;
+    Weights -> Weight[Phase][0] = (-t3 + 2 * t2 - t) * 1024;
+    Weights -> Weight[Phase][2] = (-3 * t3 + 4 * t2 + t) * 1024;
+    Weights -> Weight[Phase][3] = (t3 - t2) * 1024;
+    Weights -> Weight[Phase][1] = 2048 - Weights -> Weight[Phase][0] - Weights -> Weight[Phase][2] - Weights -> Weight[Phase][3];
+  }
+  return 0;
+}
+/**********************************************************
+Description: Separable interpolation of gray image (vertical pass, then horizontal pass).
+Input:       *Engine: Engine prepared by InterpInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *OutMat: Pointer to the first address of the output matrix (value range 0 ~ 255).      
+Output:      none 
+Return:      none    
+Others:      Same as InterpRunTile() over the whole output image.
+**********************************************************/
+uint8_t InterpRun(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutMat)
+{
+  return InterpRunTile(Engine,InMat,OutMat,0,0,Engine -> OutWidth,Engine -> OutHeight);
+}
+/**********************************************************
+Description: Separable interpolation, emitting one output row at a time.
+Input:       *Engine: Engine prepared by InterpInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *RowMat: Buffer of one output row (OutWidth gray bytes, or OutWidth RGB565 words when Palette is set).
+             *Palette: 256-entry RGB565 palette, NULL to emit gray values.
+             Sink: Called for every output row, from top to bottom.
+             *Arg: User argument passed to Sink.
+Output:      none 
+Return:      none    
+Others:      RowMat is overwritten for every row, Sink must consume it before returning.
+**********************************************************/
+uint8_t InterpRunStream(InterpEngine *Engine,uint8_t *InMat,void *RowMat,const unsigned int *Palette,ThermalImagingRowSink Sink,void *Arg)
+{
+  uint16_t row;
+
+  for(row = 0;row < Engine -> OutHeight;row++)
+  {
+    InterpRows(Engine,InMat,(uint8_t *)RowMat,(uint16_t *)RowMat,Palette,NULL,0,row,Engine -> OutWidth,1);
+    Sink(row,RowMat,Engine -> OutWidth,Arg);
+  }
+  return 0;
+}
+/**********************************************************
+Description: Separable interpolation of one rectangular tile of the output image.
+Input:       *Engine: Engine prepared by InterpInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *OutMat: Pointer to the first address of the TileWidth * TileHeight tile (value range 0 ~ 255).      
+             xStart: Left column of the tile in the output image.
+             yStart: Top row of the tile in the output image.
+             TileWidth: Tile width.
+             TileHeight: Tile height.
+Output:      none 
+Return:      0: success  1: tile outside the output image    
+Others:      Tiles of the same image join seamlessly.
+**********************************************************/
+uint8_t InterpRunTile(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight)
+{
+  return InterpRows(Engine,InMat,OutMat,NULL,NULL,NULL,xStart,yStart,TileWidth,TileHeight);
+}
+/**********************************************************
+Description: Separable interpolation of one rectangular tile straight to RGB565 pixels.
+Input:       *Engine: Engine prepared by InterpInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *OutColor: Pointer to the first address of the TileWidth * TileHeight RGB565 tile.      
+             *Palette: 256-entry RGB565 palette indexed by gray value (e.g. Rainbow2_65K).
+             xStart: Left column of the tile in the output image.
+             yStart: Top row of the tile in the output image.
+             TileWidth: Tile width.
+             TileHeight: Tile height.
+Output:      none 
+Return:      0: success  1: tile outside the output image or no palette    
+Others:      The palette lookup is done in the interpolation loop, so the 
+             result can be sent to the display without a second pass.
+**********************************************************/
+uint8_t InterpRunTileColor(InterpEngine *Engine,uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight)
+{
+  if(Palette == NULL) return 1;
+  return InterpRows(Engine,InMat,NULL,OutColor,Palette,NULL,xStart,yStart,TileWidth,TileHeight);
+}
+/**********************************************************
+Description: Edge asymmetry of four neighbouring samples for the KernelEdge kernel.
+Input:       p0,p1,p2,p3: Samples at -1, 0, +1, +2 around the interpolated position (gray units).
+Output:      none 
+Return:      |p2 - p0| - |p3 - p1|, range -255 ~ 255 (that is -1 ~ 1 in 1/256 steps)    
+Others:      Positive when the left side is steeper than the right side.
+**********************************************************/
+static int32_t EdgeAsymmetry(int32_t p0,int32_t p1,int32_t p2,int32_t p3)
+{
+  int32_t Left  = p2 - p0;
+  int32_t Right = p3 - p1;
+
+  if(Left  < 0) Left  = -Left;
+  if(Right < 0) Right = -Right;
+  Left -= Right;
+  return Left > 255 ? 255 : (Left < -255 ? -255 : Left);
+}
+/**********************************************************
+Description: Separable interpolation core shared by the gray and RGB565 outputs.
+Input:       *Engine: Engine prepared by InterpInit().
+             *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
+             *OutGray: Gray output, used when Palette is NULL.
+             *OutColor: RGB565 output, used when Palette is set.
+             *Palette: 256-entry RGB565 palette or NULL.
+             xStart,yStart,TileWidth,TileHeight: Rectangle of the output image to produce.
+Output:      none 
+Return:      0: success  1: tile outside the output image    
+Others:      For every output row the source rows are first blended into one 
+             intermediate row of InWidth values, which is then interpolated 
+             horizontally. The vertical cost is shared by all pixels of the 
+             row, so a bilinear pixel needs about 2 multiplies and a bicubic 
+             pixel about 4. KernelEdge is a warped-distance linear kernel: 
+             the phase t is moved to t + A * t * (1 - t), where A is the 
+             difference of the gradients on both sides, so the blend leans 
+             to the flatter side and hot targets keep sharp borders instead 
+             of the diamond artefacts of plain bilinear interpolation.
+**********************************************************/
+static uint8_t InterpRows(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutGray,uint16_t *OutColor,const unsigned int *Palette,const uint8_t *GrayMap,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight)
+{
+  uint16_t row,col;
+  uint16_t InWidth = Engine -> InWidth;
+  uint16_t Last = Engine -> InHeight - 1;
+  uint8_t *Line[4];
+  int32_t RowBuf[MaxInWidth + 3];    //Vertically interpolated row, padded by one column on the left and two on the right
+  int32_t *Tap;
+  const int16_t *Wy,*Wx;
+  uint32_t fy,fx;
+  int32_t Value,w1,Curve,Warp;
+  uint16_t sx,sy,x;
+  uint8_t k;
+
+  if((uint32_t)xStart + TileWidth > Engine -> OutWidth || (uint32_t)yStart + TileHeight > Engine -> OutHeight) return 1;
+  fy = Engine -> RowStart + yStart * Engine -> RowStep;
+  for(row = 0;row < TileHeight;row++,fy += Engine -> RowStep)
+  {
+    sy = fy >> 16;
+
+    //Vertical pass into RowBuf[1 .. InWidth]
+    if(Engine -> Kernel == KernelBilinear)
+    {
+      w1 = (fy & 0xffff) >> 5;
+      Line[0] = InMat + sy * InWidth;
+      Line[1] = Line[0] + InWidth;
+      for(x = 0;x < InWidth;x++)
+      {
+        RowBuf[x + 1] = (int32_t)Line[0][x] * (2048 - w1) + (int32_t)Line[1][x] * w1;
+      }
+    }
+    else
+    {
+      Line[0] = InMat + (sy == 0 ? 0 : sy - 1) * InWidth;
+      Line[1] = InMat + sy * InWidth;
+      Line[2] = Line[1] + InWidth;
+      Line[3] = InMat + (sy + 2 > Last ? Last : sy + 2) * InWidth;
+      if(Engine -> Kernel == KernelEdge)
+      {
+        w1 = (fy & 0xffff) >> 5;
+        Curve = (w1 * (2048 - w1)) >> 11;
+        for(x = 0;x < InWidth;x++)
+        {
+          Warp = w1 + ((EdgeAsymmetry(Line[0][x],Line[1][x],Line[2][x],Line[3][x]) * Curve) >> 8);
+          RowBuf[x + 1] = (int32_t)Line[1][x] * (2048 - Warp) + (int32_t)Line[2][x] * Warp;
+        }
+      }
+      else
+      {
+        Wy = Engine -> Weights -> Weight[(fy & 0xffff) >> (16 - InterpPhaseBits)];
+        for(x = 0;x < InWidth;x++)
+        {
+          Value = 0;
+          for(k = 0;k < 4;k++) Value += (int32_t)Line[k][x] * Wy[k];
+          RowBuf[x + 1] = Value;
+        }
+      }
+    }
+    //Replicate the edge columns so the horizontal taps never leave the buffer
+    RowBuf[0] = RowBuf[1];
+    RowBuf[InWidth + 1] = RowBuf[InWidth];
+    RowBuf[InWidth + 2] = RowBuf[InWidth];
+
+    //Horizontal pass
+    fx = Engine -> ColStart + xStart * Engine -> ColStep;
+    if(Engine -> Kernel == KernelBilinear)
+    {
+      col = GrayMap != NULL ? 0 : SimdBilinearCols(RowBuf + 1,fx,Engine -> ColStep,TileWidth,OutGray,OutColor,Palette);
+      fx += col * Engine -> ColStep;
+      if(Palette != NULL) OutColor += col;
+      else                OutGray  += col;
+      for(;col < TileWidth;col++,fx += Engine -> ColStep)
+      {
+        Tap = RowBuf + (fx >> 16) + 1;
+        w1 = (fx & 0xffff) >> 5;
+        Value = (Tap[0] * (2048 - w1) + Tap[1] * w1) >> 22;
+        if(Palette != NULL) *OutColor++ = Palette[Value];
+        else                *OutGray++  = GrayMap != NULL ? GrayMap[Value] : Value;
+      }
+    }
+    else if(Engine -> Kernel == KernelEdge)
+    {
+      for(col = 0;col < TileWidth;col++,fx += Engine -> ColStep)
+      {
+        Tap = RowBuf + (fx >> 16);
+        w1 = (fx & 0xffff) >> 5;
+        Curve = (w1 * (2048 - w1)) >> 11;
+        Warp = w1 + ((EdgeAsymmetry(Tap[0] >> 11,Tap[1] >> 11,Tap[2] >> 11,Tap[3] >> 11) * Curve) >> 8);
+        Value = (Tap[1] * (2048 - Warp) + Tap[2] * Warp) >> 22;
+        if(Palette != NULL) *OutColor++ = Palette[Value];
+        else                *OutGray++  = GrayMap != NULL ? GrayMap[Value] : Value;
+      }
+    }
+    else
+    {
+      for(col = 0;col < TileWidth;col++,fx += Engine -> ColStep)
+      {
+        sx = fx >> 16;
+        Tap = RowBuf + sx;
+        Wx = Engine -> Weights -> Weight[(fx & 0xffff) >> (16 - InterpPhaseBits)];
+        Value = (Tap[0] * Wx[0] + Tap[1] * Wx[1] + Tap[2] * Wx[2] + Tap[3] * Wx[3] + ((int32_t)1 << 21)) >> 22;
+        Value = Value < 0 ? 0 : (Value > 255 ? 255 : Value);
+        if(Palette != NULL) *OutColor++ = Palette[Value];
+        else                *OutGray++  = GrayMap != NULL ? GrayMap[Value] : Value;
+      }
+    }
+  }
+  return 0;
+}
+/**********************************************************
 Description: Convert temperature matrix to gray matrix.
 Input:       *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).
              *OutMat: Pointer to the first address of the output matrix (value range 0 ~ 255).      
@@ -97,16 +796,16 @@ Output:      none
 Return:      none    
 Others:      none
 **********************************************************/
-uint8_t TransformGray(float *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight,float Max,float Min)
+uint8_t TransformGray(float *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,float Max,float Min)
 {
   float SubValue;
-  uint16_t Num,temp;
+  uint32_t Num,temp;
 
   //First normalize and then multiply 255 to gray value
   SubValue = Max - Min;
   if(SubValue == 0) SubValue = 1;
-  temp = InWidth * InHeight;
-  for(Num = 0; Num < temp; Num++)
+  temp = (uint32_t)InWidth * InHeight;
+  for(Num = SimdGrayFloat(InMat,OutMat,temp,Min,SubValue); Num < temp; Num++)
   {
     OutMat[Num] = ((InMat[Num] - Min) * 255) / SubValue;
   }
@@ -114,6 +813,37 @@ uint8_t TransformGray(float *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHei
   return 0;
 }
 /**********************************************************
+Description: Convert quarter-degree temperature matrix to gray matrix without floating point.
+Input:       *InMat: Pointer to the first address of the raw matrix (unit: 0.25 degC, e.g. readRawPixelsAndMaximum()).
+             *OutMat: Pointer to the first address of the output matrix (value range 0 ~ 255).      
+             InWidth: Original image width.
+             InHeight: Original image height.
+             Max: Maximum raw temperature (unit: 0.25 degC).
+             Min: Minimum raw temperature (unit: 0.25 degC).
+Output:      none 
+Return:      none    
+Others:      One Q16 reciprocal of the range is computed per frame, rounded up, 
+             and every pixel costs a multiply and a shift instead of a float 
+             divide. The result equals TransformGray() on the same data for 
+             ranges below 64 degC and is at most 1 level higher above that.
+**********************************************************/
+uint8_t TransformGrayFixed(int16_t *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,int16_t Max,int16_t Min)
+{
+  uint32_t Scale,Diff,Range;
+  uint32_t Num,Total;
+
+  Range = Max > Min ? Max - Min : 1;
+  Scale = (((uint32_t)255 << 16) + Range - 1) / Range;
+  Total = (uint32_t)InWidth * InHeight;
+  for(Num = SimdGrayFixed(InMat,OutMat,Total,Max,Min,Scale);Num < Total;Num++)
+  {
+    Diff = InMat[Num] <= Min ? 0 : (InMat[Num] >= Max ? Range : (uint32_t)(InMat[Num] - Min));
+    OutMat[Num] = (Diff * Scale) >> 16;
+  }
+
+  return 0;
+}
+/**********************************************************
 Description: Background Filtering 
 Input:       *InMat: Pointer to the first address of the original matrix (value range 0 ~ 255).  
              InWidth: Original image width.
@@ -121,45 +851,66 @@ Input:       *InMat: Pointer to the first address of the original matrix (value
              Threshold: Threshold for segmenting background and target (value range 0 ~ 255).
              Background: Background removal degreeThe empirical value is 20(value range 0 ~ 255).
 Output:      none 
+Return:      0: success    
+Others:      In-place form of BackgroundSuppress() with Neighbors4, any image size.
+**********************************************************/
+uint8_t BackgroundFiltering(uint8_t *InMat,uint16_t InWidth,uint16_t InHeight,uint8_t Threshold,uint8_t Background)
+{
+  return BackgroundSuppress(InMat,InMat,InWidth,InHeight,Threshold,Background,Neighbors4);
+}
+/**********************************************************
+Description: Background suppression from a source matrix into a destination matrix.
+Input:       *SrcMat: Pointer to the first address of the original matrix (value range 0 ~ 255).  
+             *DstMat: Pointer to the first address of the output matrix, SrcMat itself or not overlapping it.  
+             Width: Image width.
+             Height: Image height.
+             Threshold: Threshold for segmenting background and target (value range 0 ~ 255).
+             Background: Background removal degree, the empirical value is 20 (0: copy without filtering).
+             Neighbors: Neighbors4 (up, down, left, right) or Neighbors8 (also the diagonals).
+Output:      none 
 Return:      none    
-Others:      none
+Others:      A pixel below Threshold is kept only when a neighbour is at or above 
+             Threshold and at least Background brighter, otherwise it becomes 0. 
+             Only pixels below Threshold are cleared, and those can never keep a 
+             neighbour, so the result does not depend on the scan order and 
+             DstMat may be SrcMat (in place, no copy). Neighbours outside the image are replaced by the 
+             pixel itself, which can never keep it, so the loop has no edge 
+             branches and the keep/clear choice is a mask.
 **********************************************************/
-uint8_t BackgroundFiltering(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight,uint8_t Threshold,uint8_t Background)
-{
-  uint16_t row,col,temp;
-
-  if(Background != 0)
-  { 
-    for(row = 0;row < InWidth;row++)
-    {
-      for(col = 0;col < InHeight;col++)
-      {   
-        if(InMat[row * InWidth + col] < Threshold)
-        { 
-          if(row != 0)
-          {
-            temp = (row - 1) * InWidth + col;
-            if((InMat[temp] >= Threshold) && (InMat[temp] - InMat[(row) * InWidth + col] >= Background))   continue;
-          }
-          if(row != InHeight - 1)
-          {
-            temp = (row + 1) * InWidth + col;
-            if((InMat[temp] >= Threshold) && (InMat[temp] - InMat[(row) * InWidth + col] >= Background))   continue;
-          }
-          if(col != 0)
-          {
-            temp = row * InWidth + col - 1 ;
-            if((InMat[temp] >= Threshold) && (InMat[temp] - InMat[temp+1] >= Background))     continue;
-          }
-          if(col != InWidth-1)
-          {
-            temp = row * InWidth + col + 1;
-            if((InMat[temp] >= Threshold) && (InMat[temp] - InMat[temp-1] >= Background))     continue;
-          }
-          InMat[row * InWidth + col] = 0;
-        }
-      }
-    } 
+uint8_t BackgroundSuppress(uint8_t *SrcMat,uint8_t *DstMat,uint16_t Width,uint16_t Height,uint8_t Threshold,uint8_t Background,uint8_t Neighbors)
+{
+  uint16_t row,col,Left,Right;
+  uint8_t *Up,*Mid,*Down;
+  uint8_t Diag;
+  int16_t Pixel,Keep;
+
+  if(Background == 0)
+  {
+    if(DstMat != SrcMat) memcpy(DstMat,SrcMat,(uint32_t)Width * Height);
+    return 0;
+  }
+  Diag = (Neighbors == Neighbors8);
+  for(row = 0;row < Height;row++)
+  {
+    Mid  = SrcMat + (uint32_t)row * Width;
+    Up   = row == 0          ? Mid : Mid - Width;
+    Down = row == Height - 1 ? Mid : Mid + Width;
+    for(col = 0;col < Width;col++)
+    {
+      Left  = col - (col != 0);
+      Right = col + (col != Width - 1);
+      Pixel = Mid[col];
+      Keep  = (Pixel >= Threshold) |
+              ((Up[col]      >= Threshold) & (Up[col]      - Pixel >= Background)) |
+              ((Down[col]    >= Threshold) & (Down[col]    - Pixel >= Background)) |
+              ((Mid[Left]    >= Threshold) & (Mid[Left]    - Pixel >= Background)) |
+              ((Mid[Right]   >= Threshold) & (Mid[Right]   - Pixel >= Background)) |
+              (Diag & (((Up[Left]    >= Threshold) & (Up[Left]    - Pixel >= Background)) |
+                       ((Up[Right]   >= Threshold) & (Up[Right]   - Pixel >= Background)) |
+                       ((Down[Left]  >= Threshold) & (Down[Left]  - Pixel >= Background)) |
+                       ((Down[Right] >= Threshold) & (Down[Right] - Pixel >= Background))));
+      *DstMat++ = Pixel & -Keep;
+    }
   }
   return 0;
 }
@@ -172,15 +923,10 @@ Output:      none
 Return:      Segmentation threshold between background and target   
 Others:      none
 **********************************************************/
-uint8_t Otus(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight)
+uint8_t Otus(uint8_t *InMat,uint16_t InWidth,uint16_t InHeight)
 { 
-   float Value,SumValue1,SumValue2,temp;
-   float GrayProbabilitySum[64]        = {0};
-   float GrayMeanSum[64]               = {0}; 
-   uint8_t GrayNum[MaxGrayscale] = {0};
-   uint8_t OrderMat[64]          = {0};
-   unsigned int TotalPixels;
-   unsigned int row,col,Num,Threshold,value,ComparTh;
+   uint16_t GrayNum[MaxGrayscale] = {0};
+   unsigned int row,col;
   
   //Statistical gray histogram
   for(row = 0;row < InHeight;row++)
@@ -190,10 +936,52 @@ uint8_t Otus(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight)
       GrayNum[InMat[row * InWidth + col]]++;
     }
   }
+  return OtusHistogram(GrayNum,InWidth * InHeight);
+}
+/**********************************************************
+Description: Otus algorithm on an already counted gray histogram.
+Input:       *GrayNum: Number of pixels of every gray level (MaxGrayscale bins).
+             TotalPixels: Number of pixels in the histogram.
+Output:      none 
+Return:      Segmentation threshold between background and target   
+Others:      Lets a caller that already built the histogram skip a second pass over the image. 
+             Up to MaxInPixels pixels the exact integer search is used, so the 
+             threshold is the same on every platform; larger histograms fall 
+             back to OtusHistogramFloat().
+**********************************************************/
+uint8_t OtusHistogram(uint16_t *GrayNum,unsigned int TotalPixels)
+{ 
+  uint32_t Occupied[MaxGrayscale / 32] = {0};
+  uint32_t TotalSum = 0;
+  uint16_t Level;
+
+  if(TotalPixels > MaxInPixels) return OtusHistogramFloat(GrayNum,TotalPixels);
+  for(Level = 0;Level < MaxGrayscale;Level++)
+  {
+    if(GrayNum[Level] == 0) continue;
+    TotalSum += (uint32_t)GrayNum[Level] * Level;
+    Occupied[Level >> 5] |= (uint32_t)1 << (Level & 31);
+  }
+  return OtusSearch(GrayNum,TotalPixels,TotalSum,Occupied);
+}
+/**********************************************************
+Description: Otus algorithm on a gray histogram, floating-point version.
+Input:       *GrayNum: Number of pixels of every gray level (MaxGrayscale bins).
+             TotalPixels: Number of pixels in the histogram.
+Output:      none 
+Return:      Segmentation threshold between background and target   
+Others:      Only the first 64 occupied gray levels are searched.
+**********************************************************/
+uint8_t OtusHistogramFloat(uint16_t *GrayNum,unsigned int TotalPixels)
+{ 
+   float Value,SumValue1,SumValue2,temp,value,ComparTh;
+   float GrayProbabilitySum[64]        = {0};
+   float GrayMeanSum[64]               = {0}; 
+   uint8_t OrderMat[64]          = {0};
+   unsigned int row,Num,Threshold;
   
   SumValue1 = 0;
   SumValue2 = 0;
-  TotalPixels = InWidth * InHeight;
   for(Num = 0,row = 0;Num < MaxGrayscale && row < 64;Num++)
   {
     if(GrayNum[Num] == 0) continue;
@@ -226,3 +1014,726 @@ uint8_t Otus(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight)
   }
   return (uint8_t)Threshold;
 }
+/**********************************************************
+Description: Reset the temporal Otus threshold estimator.
+Input:       *Tracker: Estimator to be reset.
+Output:      none 
+Return:      none    
+Others:      The next update counts the whole frame.
+**********************************************************/
+void OtusTrackerInit(OtusTracker *Tracker)
+{
+  memset(Tracker -> GrayNum,0,sizeof(Tracker -> GrayNum));
+  memset(Tracker -> Occupied,0,sizeof(Tracker -> Occupied));
+  Tracker -> GraySum = 0;
+  Tracker -> TotalPixels = 0;
+  Tracker -> Threshold = 0;
+}
+/**********************************************************
+Description: Otus threshold of a new frame, updated from the previous frame.
+Input:       *Tracker: Estimator holding the previous frame.
+             *InMat: Pointer to the first address of the gray matrix (value range 0 ~ 255).   
+             InWidth: Original image width.
+             InHeight: Original image height.
+Output:      none 
+Return:      Segmentation threshold between background and target   
+Others:      The histogram, its gray sum and the set of occupied levels are 
+             carried over from the previous frame: only pixels whose gray level 
+             changed are moved between bins, and an unchanged frame returns the 
+             previous threshold at once. The search then visits the occupied 
+             levels only (at most one per pixel) instead of all 256, with the 
+             same integer comparison as OtusHistogram(), so the result is always 
+             the same as a full recount of the frame. At most MaxInPixels pixels.
+**********************************************************/
+uint8_t OtusTrackerUpdate(OtusTracker *Tracker,uint8_t *InMat,uint16_t InWidth,uint16_t InHeight)
+{
+  uint16_t Num,Total,Changed;
+  uint8_t Old,New;
+
+  Total = InWidth * InHeight;
+  if(Total > MaxInPixels) return 0;
+  if(Tracker -> TotalPixels != Total)
+  {
+    //First frame or new geometry: count everything
+    OtusTrackerInit(Tracker);
+    for(Num = 0;Num < Total;Num++)
+    {
+      Tracker -> GrayNum[InMat[Num]]++;
+      Tracker -> Occupied[InMat[Num] >> 5] |= (uint32_t)1 << (InMat[Num] & 31);
+      Tracker -> GraySum += InMat[Num];
+    }
+    memcpy(Tracker -> PrevMat,InMat,Total);
+    Tracker -> TotalPixels = Total;
+    Tracker -> Threshold = OtusSearch(Tracker -> GrayNum,Total,Tracker -> GraySum,Tracker -> Occupied);
+    return Tracker -> Threshold;
+  }
+
+  //Subtract the old frame and add the new one, pixel by pixel
+  Changed = 0;
+  for(Num = 0;Num < Total;Num++)
+  {
+    Old = Tracker -> PrevMat[Num];
+    New = InMat[Num];
+    if(New == Old) continue;
+    if(--Tracker -> GrayNum[Old] == 0) Tracker -> Occupied[Old >> 5] &= ~((uint32_t)1 << (Old & 31));
+    if(Tracker -> GrayNum[New]++ == 0) Tracker -> Occupied[New >> 5] |= (uint32_t)1 << (New & 31);
+    Tracker -> GraySum += New;
+    Tracker -> GraySum -= Old;
+    Tracker -> PrevMat[Num] = New;
+    Changed++;
+  }
+  if(Changed != 0) Tracker -> Threshold = OtusSearch(Tracker -> GrayNum,Total,Tracker -> GraySum,Tracker -> Occupied);
+  return Tracker -> Threshold;
+}
+/**********************************************************
+Description: Exact integer search of the maximum interclass variance.
+Input:       *GrayNum: Number of pixels of every gray level (MaxGrayscale bins).
+             TotalPixels: Number of pixels in the histogram (at most MaxInPixels).
+             TotalSum: Sum of the gray levels of all pixels.
+             *Occupied: MaxGrayscale / 32 words with a bit set for every level 
+                        with pixels.
+Output:      none 
+Return:      Lowest gray level with the maximum interclass variance   
+Others:      With w pixels and gray sum s at or below a level, the variance is 
+             proportional to (S * w - s * N)^2 / (w * (N - w)). Candidates are 
+             compared by cross multiplication, so there is no division and the 
+             result does not depend on the platform.
+**********************************************************/
+static uint8_t OtusSearch(uint16_t *GrayNum,uint16_t TotalPixels,uint32_t TotalSum,const uint32_t *Occupied)
+{
+  uint32_t Count,Sum,Den,BestDen,Bits;
+  uint64_t Num,BestNum;
+  int32_t Diff;
+  uint16_t Level,Word;
+  uint8_t Threshold;
+
+  Threshold = 0;
+  BestNum = 0;
+  BestDen = 1;
+  Count = 0;
+  Sum = 0;
+  for(Word = 0;Word < MaxGrayscale / 32;Word++)
+  {
+    for(Bits = Occupied[Word];Bits != 0;Bits &= Bits - 1)
+    {
+      Level = Word * 32 + LowestBit(Bits);
+      Count += GrayNum[Level];
+      Sum   += (uint32_t)GrayNum[Level] * Level;
+      if(Count >= TotalPixels) return Threshold;
+      Diff = (int32_t)(TotalSum * Count) - (int32_t)(Sum * TotalPixels);
+      Num = (uint64_t)((int64_t)Diff * Diff);
+      Den = Count * (TotalPixels - Count);
+      if(Num * BestDen > BestNum * Den)
+      {
+        Threshold = Level;
+        BestNum = Num;
+        BestDen = Den;
+      }
+    }
+  }
+  return Threshold;
+}
+/**********************************************************
+Description: Index of the lowest set bit.
+Input:       Bits: Non-zero word.
+Output:      none 
+Return:      0 ~ 31    
+Others:      One instruction with GCC, a de Bruijn multiply elsewhere.
+**********************************************************/
+static uint8_t LowestBit(uint32_t Bits)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(Bits);
+#else
+  static const uint8_t Position[32] = {0, 1,28, 2,29,14,24, 3,30,22,20,15,25,17, 4, 8,
+                                       31,27,13,23,21,19,16, 7,26,12,18, 6,11, 5,10, 9};
+  return Position[(uint32_t)((Bits & (0 - Bits)) * 0x077CB531UL) >> 27];
+#endif
+}
+/**********************************************************
+Description: Prepare the automatic gain control stage.
+Input:       *Gain: Stage object to be initialized.
+             Mode: AgcSmoothRange and/or AgcEqualize.
+             SmoothShift: Smoothing time constant of about 2^SmoothShift frames (0 ~ 8, 0: no smoothing).
+             Plateau: Clip limit of one histogram bin in 1/256 of the pixels, e.g. 16 (0: no clipping).
+Output:      none 
+Return:      none    
+Others:      The first frame seeds the smoothed state.
+**********************************************************/
+void AutoGainInit(AutoGain *Gain,uint8_t Mode,uint8_t SmoothShift,uint8_t Plateau)
+{
+  uint16_t Num;
+
+  Gain -> Mode        = Mode;
+  Gain -> SmoothShift = SmoothShift > 8 ? 8 : SmoothShift;
+  Gain -> Plateau     = Plateau;
+  Gain -> Primed      = 0;
+  Gain -> RangeMax    = 0;
+  Gain -> RangeMin    = 0;
+  for(Num = 0;Num < MaxGrayscale;Num++)
+  {
+    Gain -> Curve[Num] = Num << 8;
+    Gain -> Lut[Num]   = Num;
+  }
+}
+/**********************************************************
+Description: Exponentially smoothed temperature range of a new frame.
+Input:       *Gain: Stage prepared by AutoGainInit().
+             *Max: Maximum temperature of the frame, replaced by the range to be mapped.
+             *Min: Minimum temperature of the frame, replaced by the range to be mapped.
+Output:      none 
+Return:      0: range smoothed  1: AgcSmoothRange not enabled, range unchanged    
+Others:      The state is kept in 1/256 degC, so the 0.25 degC sensor steps are 
+             exact and SmoothShift 0 maps exactly like the unsmoothed range.
+**********************************************************/
+uint8_t AutoGainRange(AutoGain *Gain,float *Max,float *Min)
+{
+  int32_t NewMax,NewMin;
+
+  if((Gain -> Mode & AgcSmoothRange) == 0) return 1;
+  NewMax = *Max * 256;
+  NewMin = *Min * 256;
+  if((Gain -> Primed & AgcSmoothRange) == 0)
+  {
+    Gain -> RangeMax = NewMax;
+    Gain -> RangeMin = NewMin;
+    Gain -> Primed |= AgcSmoothRange;
+  }
+  else
+  {
+    Gain -> RangeMax += (NewMax - Gain -> RangeMax) / (1 << Gain -> SmoothShift);
+    Gain -> RangeMin += (NewMin - Gain -> RangeMin) / (1 << Gain -> SmoothShift);
+  }
+  if(Gain -> RangeMax <= Gain -> RangeMin) Gain -> RangeMax = Gain -> RangeMin + 1;
+  *Max = (float)Gain -> RangeMax / 256;
+  *Min = (float)Gain -> RangeMin / 256;
+  return 0;
+}
+/**********************************************************
+Description: Plateau histogram equalization curve of a new frame.
+Input:       *Gain: Stage prepared by AutoGainInit().
+             *GrayNum: Number of pixels of every gray level (MaxGrayscale bins), e.g. the Otus histogram.
+             TotalPixels: Number of pixels in the histogram.
+Output:      Gain -> Lut: Gray level mapping to be applied to the frame.
+Return:      0: curve ready  1: AgcEqualize not enabled    
+Others:      Every bin is clipped to the plateau before the cumulative sum, so a 
+             large uniform background cannot take most of the levels. The 
+             lowest occupied level maps to 0 and the highest to 255, the curve 
+             is smoothed in 1/256 gray levels and stays monotonic, and level 0 
+             always maps to 0. Integer only.
+**********************************************************/
+uint8_t AutoGainEqualize(AutoGain *Gain,uint16_t *GrayNum,unsigned int TotalPixels)
+{
+  uint32_t Limit,Sum,First,Cdf,Target;
+  uint16_t Num;
+
+  if((Gain -> Mode & AgcEqualize) == 0) return 1;
+  Limit = Gain -> Plateau == 0 ? TotalPixels : ((uint32_t)TotalPixels * Gain -> Plateau + 255) >> 8;
+  Sum = 0;
+  First = 0;
+  for(Num = 0;Num < MaxGrayscale;Num++)
+  {
+    Sum += GrayNum[Num] < Limit ? GrayNum[Num] : Limit;
+    if(First == 0) First = Sum;
+  }
+
+  Cdf = 0;
+  for(Num = 0;Num < MaxGrayscale;Num++)
+  {
+    Cdf += GrayNum[Num] < Limit ? GrayNum[Num] : Limit;
+    if(Sum == First)  Target = (uint32_t)Num << 8;           //Single level: identity
+    else if(Cdf == 0) Target = 0;
+    else              Target = ((Cdf - First) * 255 << 8) / (Sum - First);
+    if((Gain -> Primed & AgcEqualize) == 0) Gain -> Curve[Num] = Target;
+    else Gain -> Curve[Num] += ((int32_t)Target - Gain -> Curve[Num]) / (1 << Gain -> SmoothShift);
+    Gain -> Lut[Num] = (Gain -> Curve[Num] + 128) >> 8;
+  }
+  Gain -> Primed |= AgcEqualize;
+  return 0;
+}
+/**********************************************************
+Description: Build the palette or gray mapping of one frame with the isotherm bands marked.
+Input:       *Overlay: Overlay holding the bands.
+             PixelFormat: PixelRGB565 fills Overlay -> Palette, PixelGray8 fills Overlay -> GrayMap.
+             *Palette: 256-entry RGB565 base palette (PixelRGB565 only).
+             Max: Temperature mapped to gray level 255.
+             Min: Temperature mapped to gray level 0.
+             *Lut: Equalization curve applied after the linear mapping, NULL for none.
+Output:      none 
+Return:      0: success  1: RGB565 without base palette    
+Others:      A band covers the gray levels whose temperature Min + Gray * (Max - Min) / 255 
+             lies in TempLow ~ TempHigh, so the interpolated pixels are compared 
+             with the original temperatures. The pipeline calls this once per 
+             frame, 256 table entries plus the band ranges, and the pixels are 
+             marked by the lookup they already go through.
+**********************************************************/
+uint8_t IsothermBuild(IsothermOverlay *Overlay,uint8_t PixelFormat,const unsigned int *Palette,float Max,float Min,const uint8_t *Lut)
+{
+  IsothermBand *Band;
+  float Scale,Low,High;
+  int16_t First,Last,Num;
+  uint8_t k;
+
+  if(PixelFormat == PixelRGB565)
+  {
+    if(Palette == NULL) return 1;
+    memcpy(Overlay -> Palette,Palette,sizeof(Overlay -> Palette));
+  }
+  else
+  {
+    for(Num = 0;Num < MaxGrayscale;Num++) Overlay -> GrayMap[Num] = Num;
+  }
+  Scale = Max > Min ? 255 / (Max - Min) : 255;
+  for(k = 0;k < Overlay -> Count && k < MaxIsotherms;k++)
+  {
+    //Same 0.001 bias as PrepareGrayFused(), so a band edge on a 0.25 degC step includes that level
+    Band = &Overlay -> Band[k];
+    Low  = (Band -> TempLow  - Min) * Scale - (float)0.001;
+    High = (Band -> TempHigh - Min) * Scale + (float)0.001;
+    if(High < 0 || Low > 255 || High < Low) continue;
+    First = Low <= 0 ? 0 : (int16_t)Low + (Low > (int16_t)Low);
+    Last  = High >= 255 ? 255 : (int16_t)High;
+    if(Lut != NULL)
+    {
+      First = Lut[First];
+      Last  = Lut[Last];
+    }
+    for(Num = First;Num <= Last;Num++)
+    {
+      if(PixelFormat == PixelRGB565) Overlay -> Palette[Num] = Band -> Color;
+      else                           Overlay -> GrayMap[Num] = Band -> Gray;
+    }
+  }
+  return 0;
+}
+/**********************************************************
+Description: Prepare the multi-frame super-resolution stage.
+Input:       *SuperRes: Stage object to be initialized.
+             InWidth: Original image width.
+             InHeight: Original image height.
+             Scale: Grid cells per input pixel in each direction (e.g. 2: 8*8 -> 16*16).
+             WindowShift: Accumulation window of about 2^WindowShift frames (0 ~ 6).
+Output:      none 
+Return:      0: success  1: grid exceeds MaxSuperResPixels or unsupported parameters    
+Others:      The output grid is InWidth * Scale by InHeight * Scale and can be 
+             used as InMat of a ThermalImagingConfig.
+**********************************************************/
+uint8_t SuperResInit(SuperResolution *SuperRes,uint16_t InWidth,uint16_t InHeight,uint8_t Scale,uint8_t WindowShift)
+{
+  if(Scale == 0 || WindowShift > 6 || InWidth < 3 || InHeight < 3) return 1;
+  if((uint32_t)InWidth * InHeight > MaxInPixels) return 1;
+  if((uint32_t)InWidth * Scale * InHeight * Scale > MaxSuperResPixels) return 1;
+  SuperRes -> InWidth     = InWidth;
+  SuperRes -> InHeight    = InHeight;
+  SuperRes -> Scale       = Scale;
+  SuperRes -> WindowShift = WindowShift;
+  SuperRes -> Frames      = 0;
+  SuperRes -> ShiftX      = 0;
+  SuperRes -> ShiftY      = 0;
+  memset(SuperRes -> Mean,0,sizeof(SuperRes -> Mean));
+  memset(SuperRes -> Weight,0,sizeof(SuperRes -> Weight));
+  return 0;
+}
+/**********************************************************
+Description: Add one frame to the super-resolution grid.
+Input:       *SuperRes: Stage prepared by SuperResInit().
+             *InMat: Temperature matrix of the new frame (InWidth * InHeight, unit: degC).
+             *OutMat: Super-resolved temperature matrix (InWidth * Scale by InHeight * Scale, unit: degC).
+Output:      none 
+Return:      0: frame accumulated  1: motion too large, the grid was re-anchored on this frame    
+Others:      1. The global shift against the previous frame is estimated with one 
+                integer Lucas-Kanade step over the interior pixels.
+             2. The shifts are summed into the position of the frame relative to 
+                the reference; above one input pixel the grid is restarted.
+             3. The cell weights decay by 2^-WindowShift and every input pixel 
+                updates the running mean of the cell its shifted centre falls 
+                into, so memory is fixed and old frames fade out; a cell no 
+                pixel falls into any more empties within a few windows.
+             4. Cells without samples take the value of the current frame.
+             The cost is O(InWidth * InHeight + grid cells) per frame, with no 
+             dependency on the window length.
+**********************************************************/
+uint8_t SuperResUpdate(SuperResolution *SuperRes,float *InMat,float *OutMat)
+{
+  uint16_t Width = SuperRes -> InWidth;
+  uint16_t Height = SuperRes -> InHeight;
+  uint8_t Scale = SuperRes -> Scale;
+  uint16_t GridWidth = Width * Scale;
+  uint16_t GridCells = GridWidth * Height * Scale;
+  int16_t Cur[MaxInPixels];
+  int64_t Sxx,Sxy,Syy,Sxt,Syt,Det;
+  int32_t gx,gy,gt,dx,dy,HX,HY;
+  uint16_t x,y,n,Cell;
+  uint8_t Restart = 0;
+
+  for(n = 0;n < Width * Height;n++)
+  {
+    Cur[n] = InMat[n] * 4 + (InMat[n] < 0 ? -(float)0.5 : (float)0.5);
+  }
+
+  if(SuperRes -> Frames == 0)
+  {
+    dx = 0;
+    dy = 0;
+  }
+  else
+  {
+    //Global shift (1/256 pixel) from the previous frame: [Sxx Sxy; Sxy Syy] * d = -2 * [Sxt; Syt]
+    Sxx = Sxy = Syy = Sxt = Syt = 0;
+    for(y = 1;y < Height - 1;y++)
+    {
+      for(x = 1;x < Width - 1;x++)
+      {
+        n  = y * Width + x;
+        gx = SuperRes -> PrevMat[n + 1] - SuperRes -> PrevMat[n - 1];
+        gy = SuperRes -> PrevMat[n + Width] - SuperRes -> PrevMat[n - Width];
+        gt = Cur[n] - SuperRes -> PrevMat[n];
+        Sxx += gx * gx;
+        Sxy += gx * gy;
+        Syy += gy * gy;
+        Sxt += gx * gt;
+        Syt += gy * gt;
+      }
+    }
+    Det = Sxx * Syy - Sxy * Sxy;
+    if(Det <= 0)
+    {
+      dx = 0;
+      dy = 0;
+    }
+    else
+    {
+      dx = -512 * (Syy * Sxt - Sxy * Syt) / Det;
+      dy = -512 * (Sxx * Syt - Sxy * Sxt) / Det;
+    }
+  }
+  SuperRes -> ShiftX += dx;
+  SuperRes -> ShiftY += dy;
+  if(dx > 256 || dx < -256 || dy > 256 || dy < -256 ||
+     SuperRes -> ShiftX > 256 || SuperRes -> ShiftX < -256 || SuperRes -> ShiftY > 256 || SuperRes -> ShiftY < -256)
+  {
+    //Lost registration: start a new reference on this frame
+    memset(SuperRes -> Weight,0,sizeof(SuperRes -> Weight));
+    SuperRes -> ShiftX = 0;
+    SuperRes -> ShiftY = 0;
+    SuperRes -> Frames = 0;
+    Restart = 1;
+  }
+
+  //Fade the window: only the weights decay, the cell means stay exact. The product rounds 
+  //down so a weight below 2^WindowShift keeps falling and an unvisited cell reaches 0
+  for(Cell = 0;Cell < GridCells;Cell++)
+  {
+    SuperRes -> Weight[Cell] = ((uint32_t)SuperRes -> Weight[Cell] * ((1 << SuperRes -> WindowShift) - 1)) >> SuperRes -> WindowShift;
+  }
+  //Scatter the frame: pixel centre x maps to grid coordinate (x - Shift) * Scale + (Scale - 1) / 2
+  for(y = 0;y < Height;y++)
+  {
+    HY = (((int32_t)y << 8) - SuperRes -> ShiftY) * Scale + 128 * (Scale - 1) + 128;
+    if(HY < 0 || (HY >> 8) >= Height * Scale) continue;
+    for(x = 0;x < Width;x++)
+    {
+      HX = (((int32_t)x << 8) - SuperRes -> ShiftX) * Scale + 128 * (Scale - 1) + 128;
+      if(HX < 0 || (HX >> 8) >= GridWidth) continue;
+      Cell = (HY >> 8) * GridWidth + (HX >> 8);
+      SuperRes -> Weight[Cell] += 16;
+      SuperRes -> Mean[Cell]   += (((int32_t)Cur[y * Width + x] << 4) - SuperRes -> Mean[Cell]) * 16 / SuperRes -> Weight[Cell];
+    }
+  }
+  //Normalize, cells without samples fall back to the current frame
+  for(Cell = 0;Cell < GridCells;Cell++)
+  {
+    if(SuperRes -> Weight[Cell] != 0)
+    {
+      OutMat[Cell] = SuperRes -> Mean[Cell] * (float)(0.25 / 16);
+    }
+    else
+    {
+      y = Cell / GridWidth / Scale;
+      x = Cell % GridWidth / Scale;
+      OutMat[Cell] = Cur[y * Width + x] * (float)0.25;
+    }
+  }
+
+  memcpy(SuperRes -> PrevMat,Cur,Width * Height * sizeof(int16_t));
+  if(SuperRes -> Frames < 255) SuperRes -> Frames++;
+  return Restart;
+}
+/**********************************************************
+Description: Choose the instruction set of the x86-64 SIMD kernels.
+Input:       Level: SimdAuto, SimdScalar, SimdSSE2 or SimdAVX2.
+Output:      none 
+Return:      Instruction set in effect    
+Others:      SimdAuto picks the best one supported by the CPU, which is also 
+             done on the first kernel call when this is never called. A level 
+             the CPU does not support falls back to SSE2 (for AVX2) or to 
+             scalar code. Every level gives the same bytes as SimdScalar, so 
+             it may be changed while other pipelines run. Microcontroller 
+             and non-x86 builds compile the scalar code only.
+**********************************************************/
+uint8_t SimdSelect(uint8_t Level)
+{
+#if defined(ThermalSimdX86)
+  uint8_t Best = SimdSSE2;
+
+#if defined(ThermalSimdAvx2)
+  //The CPU model is filled in by a constructor of the runtime before main()
+  if(__builtin_cpu_supports("avx2")) Best = SimdAVX2;
+#endif
+  if(Level == SimdAuto) Level = Best;
+  else if(Level == SimdAVX2 && Best == SimdSSE2) Level = SimdSSE2;
+  else if(Level != Best && !(Level == SimdSSE2 && Best == SimdAVX2)) Level = SimdScalar;
+  SimdLevelStore(Level);
+  return Level;
+#else
+  (void)Level;
+  return SimdScalar;
+#endif
+}
+/**********************************************************
+Description: Decode the pixel registers of the sensor into quarter-degree temperatures.
+Input:       *Bytes: Register dump starting at REG_T01L (2 bytes per pixel, low byte first).
+             *RawMat: Decoded matrix (unit: 0.25 degC).
+             Pixels: Number of pixels.
+Output:      none 
+Return:      none    
+Others:      The 12-bit two's complement values are sign extended, the same as 
+             BMS26M833::readRawPixelsAndMaximum().
+**********************************************************/
+uint8_t DecodeRawPixels(uint8_t *Bytes,int16_t *RawMat,uint16_t Pixels)
+{
+  uint16_t Num;
+
+  for(Num = SimdDecode(Bytes,RawMat,Pixels);Num < Pixels;Num++)
+  {
+    RawMat[Num] = (int16_t)((uint16_t)Bytes[2 * Num + 1] << 12 | (uint16_t)Bytes[2 * Num] << 4) >> 4;
+  }
+  return 0;
+}
+/**********************************************************
+Description: Tone a gray matrix with a palette.
+Input:       *InMat: Pointer to the first address of the gray matrix (value range 0 ~ 255).
+             *OutColor: RGB565 output matrix.
+             *Palette: 256-entry RGB565 palette (e.g. Rainbow2_65K).
+             Pixels: Number of pixels.
+Output:      none 
+Return:      0: success  1: no palette    
+Others:      none
+**********************************************************/
+uint8_t PaletteMap(uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint32_t Pixels)
+{
+  uint32_t Num;
+
+  if(Palette == NULL) return 1;
+  for(Num = SimdPalette(InMat,OutColor,Palette,Pixels);Num < Pixels;Num++)
+  {
+    OutColor[Num] = Palette[InMat[Num]];
+  }
+  return 0;
+}
+/**********************************************************
+Description: Host SIMD kernels.
+Input:       Same as the scalar loop that calls them.
+Output:      none 
+Return:      Number of leading pixels done, the caller finishes the rest    
+Others:      Each kernel does the integer arithmetic of its scalar loop lane by 
+             lane, so the results are bit-exact. x86-64 uses SSE2 and, with 
+             GCC or Clang, AVX2 functions compiled for that target and chosen 
+             at run time. The bilinear and palette kernels need a gather or 
+             a register permute, so they only have an AVX2 version. Other 
+             targets return 0.
+**********************************************************/
+#if defined(ThermalSimdX86)
+static uint8_t SimdCurrent(void)
+{
+  uint8_t Level = SimdLevelLoad();
+
+  return Level == SimdAuto ? SimdSelect(SimdAuto) : Level;
+}
+#endif
+#if defined(ThermalSimdAvx2)
+__attribute__((target("avx2"))) static uint32_t GrayFloatAvx2(float *InMat,uint8_t *OutMat,uint32_t Total,float Min,float SubValue)
+{
+  __m256 vMin = _mm256_set1_ps(Min),vSub = _mm256_set1_ps(SubValue),v255 = _mm256_set1_ps(255);
+  __m256i a,b;
+  uint32_t Num;
+
+  for(Num = 0;Num + 16 <= Total;Num += 16)
+  {
+    a = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(InMat + Num),vMin),v255),vSub));
+    b = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(InMat + Num + 8),vMin),v255),vSub));
+    a = _mm256_permute4x64_epi64(_mm256_packs_epi32(a,b),0xd8);
+    _mm_storeu_si128((__m128i *)(OutMat + Num),_mm_packus_epi16(_mm256_castsi256_si128(a),_mm256_extracti128_si256(a,1)));
+  }
+  return Num;
+}
+__attribute__((target("avx2"))) static uint32_t GrayFixedAvx2(int16_t *InMat,uint8_t *OutMat,uint32_t Total,int16_t Max,int16_t Min,uint32_t Scale)
+{
+  __m256i vMax = _mm256_set1_epi16(Max),vMin = _mm256_set1_epi16(Min);
+  __m256i Hi = _mm256_set1_epi16(Scale >> 16),Lo = _mm256_set1_epi16(Scale & 0xffff);
+  __m256i a,b;
+  uint32_t Num;
+
+  for(Num = 0;Num + 32 <= Total;Num += 32)
+  {
+    //Diff * Scale >> 16 = Diff * Hi + (Diff * Lo >> 16), both parts fit 16 bits
+    a = _mm256_sub_epi16(_mm256_max_epi16(_mm256_min_epi16(_mm256_loadu_si256((__m256i *)(InMat + Num)),vMax),vMin),vMin);
+    b = _mm256_sub_epi16(_mm256_max_epi16(_mm256_min_epi16(_mm256_loadu_si256((__m256i *)(InMat + Num + 16)),vMax),vMin),vMin);
+    a = _mm256_add_epi16(_mm256_mullo_epi16(a,Hi),_mm256_mulhi_epu16(a,Lo));
+    b = _mm256_add_epi16(_mm256_mullo_epi16(b,Hi),_mm256_mulhi_epu16(b,Lo));
+    _mm256_storeu_si256((__m256i *)(OutMat + Num),_mm256_permute4x64_epi64(_mm256_packus_epi16(a,b),0xd8));
+  }
+  return Num;
+}
+__attribute__((target("avx2"))) static uint32_t DecodeAvx2(uint8_t *Bytes,int16_t *RawMat,uint32_t Pixels)
+{
+  uint32_t Num;
+
+  for(Num = 0;Num + 16 <= Pixels;Num += 16)
+  {
+    _mm256_storeu_si256((__m256i *)(RawMat + Num),
+                        _mm256_srai_epi16(_mm256_slli_epi16(_mm256_loadu_si256((__m256i *)(Bytes + 2 * Num)),4),4));
+  }
+  return Num;
+}
+__attribute__((target("avx2"))) static uint32_t BilinearColsAvx2(int32_t *Row,uint32_t fx,uint32_t Step,uint16_t Width,uint8_t *OutGray,uint16_t *OutColor,const unsigned int *Palette)
+{
+  __m256i Fx = _mm256_add_epi32(_mm256_set1_epi32(fx),_mm256_mullo_epi32(_mm256_setr_epi32(0,1,2,3,4,5,6,7),_mm256_set1_epi32(Step)));
+  __m256i Step8 = _mm256_set1_epi32(Step * 8),Frac = _mm256_set1_epi32(0xffff),Full = _mm256_set1_epi32(2048);
+  __m256i Row0 = _mm256_loadu_si256((__m256i *)Row),Row1 = _mm256_loadu_si256((__m256i *)(Row + 1));
+  __m256i Index,w1,Tap0,Tap1,Value;
+  __m128i Pack;
+  uint32_t col;
+  uint8_t Narrow;
+
+  //Taps of a row of up to 9 source pixels (index <= 7) are picked from registers instead of gathered
+  Narrow = fx + (uint32_t)(Width - 1) * Step < ((uint32_t)8 << 16);
+  for(col = 0;col + 8 <= Width;col += 8,Fx = _mm256_add_epi32(Fx,Step8))
+  {
+    Index = _mm256_srli_epi32(Fx,16);
+    w1    = _mm256_srli_epi32(_mm256_and_si256(Fx,Frac),5);
+    if(Narrow)
+    {
+      Tap0 = _mm256_permutevar8x32_epi32(Row0,Index);
+      Tap1 = _mm256_permutevar8x32_epi32(Row1,Index);
+    }
+    else
+    {
+      Tap0 = _mm256_i32gather_epi32((const int *)Row,Index,4);
+      Tap1 = _mm256_i32gather_epi32((const int *)(Row + 1),Index,4);
+    }
+    Value = _mm256_add_epi32(_mm256_mullo_epi32(Tap0,_mm256_sub_epi32(Full,w1)),_mm256_mullo_epi32(Tap1,w1));
+    Value = _mm256_srli_epi32(Value,22);
+    if(Palette != NULL) Value = _mm256_i32gather_epi32((const int *)Palette,Value,4);
+    Pack = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(Value,Value),0x08));
+    if(Palette != NULL) _mm_storeu_si128((__m128i *)(OutColor + col),Pack);
+    else                _mm_storel_epi64((__m128i *)(OutGray + col),_mm_packus_epi16(Pack,Pack));
+  }
+  return col;
+}
+__attribute__((target("avx2"))) static uint32_t PaletteAvx2(uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint32_t Pixels)
+{
+  __m256i Color;
+  uint32_t Num;
+
+  for(Num = 0;Num + 8 <= Pixels;Num += 8)
+  {
+    Color = _mm256_i32gather_epi32((const int *)Palette,_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(InMat + Num))),4);
+    _mm_storeu_si128((__m128i *)(OutColor + Num),_mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(Color,Color),0x08)));
+  }
+  return Num;
+}
+#endif
+static uint32_t SimdGrayFloat(float *InMat,uint8_t *OutMat,uint32_t Total,float Min,float SubValue)
+{
+#if defined(ThermalSimdX86)
+  __m128 vMin,vSub,v255;
+  __m128i a,b,c,d;
+  uint32_t Num;
+
+#if defined(ThermalSimdAvx2)
+  if(SimdCurrent() == SimdAVX2) return GrayFloatAvx2(InMat,OutMat,Total,Min,SubValue);
+#endif
+  if(SimdCurrent() != SimdSSE2) return 0;
+  vMin = _mm_set1_ps(Min);
+  vSub = _mm_set1_ps(SubValue);
+  v255 = _mm_set1_ps(255);
+  for(Num = 0;Num + 16 <= Total;Num += 16)
+  {
+    //Same operations in the same order as the scalar loop, each rounded once
+    a = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(InMat + Num),vMin),v255),vSub));
+    b = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(InMat + Num + 4),vMin),v255),vSub));
+    c = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(InMat + Num + 8),vMin),v255),vSub));
+    d = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(InMat + Num + 12),vMin),v255),vSub));
+    _mm_storeu_si128((__m128i *)(OutMat + Num),_mm_packus_epi16(_mm_packs_epi32(a,b),_mm_packs_epi32(c,d)));
+  }
+  return Num;
+#else
+  (void)InMat;(void)OutMat;(void)Total;(void)Min;(void)SubValue;
+  return 0;
+#endif
+}
+static uint32_t SimdGrayFixed(int16_t *InMat,uint8_t *OutMat,uint32_t Total,int16_t Max,int16_t Min,uint32_t Scale)
+{
+#if defined(ThermalSimdX86)
+  __m128i vMax,vMin,Hi,Lo,a,b;
+  uint32_t Num;
+
+  if(Max <= Min) return 0;
+#if defined(ThermalSimdAvx2)
+  if(SimdCurrent() == SimdAVX2) return GrayFixedAvx2(InMat,OutMat,Total,Max,Min,Scale);
+#endif
+  if(SimdCurrent() != SimdSSE2) return 0;
+  vMax = _mm_set1_epi16(Max);
+  vMin = _mm_set1_epi16(Min);
+  Hi = _mm_set1_epi16(Scale >> 16);
+  Lo = _mm_set1_epi16(Scale & 0xffff);
+  for(Num = 0;Num + 16 <= Total;Num += 16)
+  {
+    a = _mm_sub_epi16(_mm_max_epi16(_mm_min_epi16(_mm_loadu_si128((__m128i *)(InMat + Num)),vMax),vMin),vMin);
+    b = _mm_sub_epi16(_mm_max_epi16(_mm_min_epi16(_mm_loadu_si128((__m128i *)(InMat + Num + 8)),vMax),vMin),vMin);
+    a = _mm_add_epi16(_mm_mullo_epi16(a,Hi),_mm_mulhi_epu16(a,Lo));
+    b = _mm_add_epi16(_mm_mullo_epi16(b,Hi),_mm_mulhi_epu16(b,Lo));
+    _mm_storeu_si128((__m128i *)(OutMat + Num),_mm_packus_epi16(a,b));
+  }
+  return Num;
+#else
+  (void)InMat;(void)OutMat;(void)Total;(void)Max;(void)Min;(void)Scale;
+  return 0;
+#endif
+}
+static uint32_t SimdDecode(uint8_t *Bytes,int16_t *RawMat,uint32_t Pixels)
+{
+#if defined(ThermalSimdX86)
+  uint32_t Num;
+
+#if defined(ThermalSimdAvx2)
+  if(SimdCurrent() == SimdAVX2) return DecodeAvx2(Bytes,RawMat,Pixels);
+#endif
+  if(SimdCurrent() != SimdSSE2) return 0;
+  for(Num = 0;Num + 8 <= Pixels;Num += 8)
+  {
+    _mm_storeu_si128((__m128i *)(RawMat + Num),_mm_srai_epi16(_mm_slli_epi16(_mm_loadu_si128((__m128i *)(Bytes + 2 * Num)),4),4));
+  }
+  return Num;
+#else
+  (void)Bytes;(void)RawMat;(void)Pixels;
+  return 0;
+#endif
+}
+static uint32_t SimdBilinearCols(int32_t *Row,uint32_t fx,uint32_t Step,uint16_t Width,uint8_t *OutGray,uint16_t *OutColor,const unsigned int *Palette)
+{
+#if defined(ThermalSimdAvx2)
+  if(SimdCurrent() == SimdAVX2) return BilinearColsAvx2(Row,fx,Step,Width,OutGray,OutColor,Palette);
+#endif
+  (void)Row;(void)fx;(void)Step;(void)Width;(void)OutGray;(void)OutColor;(void)Palette;
+  return 0;
+}
+static uint32_t SimdPalette(uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint32_t Pixels)
+{
+#if defined(ThermalSimdAvx2)
+  if(SimdCurrent() == SimdAVX2) return PaletteAvx2(InMat,OutColor,Palette,Pixels);
+#endif
+  (void)InMat;(void)OutColor;(void)Palette;(void)Pixels;
+  return 0;
+}
@@ -7,27 +7,229 @@ V1.0.1   -- initial version；2021-09-01；Arduino IDE :v1.8.15
 ******************************************************************/
 #ifndef _INFRAREDTHERMALIMAGING_H_
 #define _INFRAREDTHERMALIMAGING_H_
+#if defined(ARDUINO)
 #include <Arduino.h>
+#else
+#include <stdint.h>              //Host builds (e.g. ThermalImagingPool) need no Arduino core
+#include <stddef.h>
+#include <string.h>
+#endif
 
+#define MaxOutSize 64            //Capacity of the precomputed interpolation tables (maximum OutWidth/OutHeight)
+#define MaxInWidth 32            //Capacity of the intermediate row of the separable interpolation engine
+#define MaxInPixels 256          //Capacity of the gray scratch matrix (maximum InWidth * InHeight) of the fused pipeline
+#define MaxGrayscale 256
+#define MaxSuperResPixels 256    //Capacity of the super-resolution grid (maximum InWidth * Scale * InHeight * Scale)
+#define MaxIsotherms 4           //Capacity of the isotherm overlay
+#define BatchGroup 8             //Frames of a batch whose gray matrices are interpolated together
+#define BatchBandRows 8          //Output rows of every frame of a group produced before moving to the next band
+#define InterpPhaseBits 6        //Sub-pixel phases in the bicubic weight table = 2^InterpPhaseBits
+#define InterpPhases (1 << InterpPhaseBits)
+
+/*Output pixel format*/
+#define PixelGray8     0         //One gray byte per pixel (value range 0 ~ 255)
+#define PixelRGB565    1         //One RGB565 word per pixel, toned by the palette during interpolation
+
+/*Background suppression neighbourhood*/
+#define Neighbors4     4
+#define Neighbors8     8
+
+/*Interpolation kernel*/
+#define KernelBilinear 0
+#define KernelBicubic  1
+#define KernelEdge     2
+
+/*Automatic gain control modes, may be combined*/
+#define AgcSmoothRange 0x01      //Map an exponentially smoothed TempMin..TempMax instead of the range of the frame
+#define AgcEqualize    0x02      //Plateau histogram equalization of the gray levels
+
+/*Instruction set of the x86-64 SIMD kernels, see SimdSelect(); other targets (ARM, AVR...) run the scalar code*/
+#define SimdScalar     0
+#define SimdSSE2       1
+#define SimdAVX2       2
+#define SimdAuto       0xff      //Best instruction set supported by the CPU
+
+typedef struct 
+{
+	uint16_t InWidth;
+	uint16_t InHeight;
+	uint16_t OutWidth;
+	uint16_t OutHeight;
+	uint16_t ColIndex[MaxOutSize];
+	uint16_t ColWeight[MaxOutSize];
+	uint16_t RowIndex[MaxOutSize];
+	uint16_t RowWeight[MaxOutSize];
+}BilinearTable;
+
+/*Catmull-Rom weights of the bicubic kernel: only KernelBicubic engines need one, and it is 
+  read-only after InterpInit(), so several engines may share it*/
+typedef struct 
+{
+	int16_t Weight[InterpPhases][4];   //2048-scaled bicubic weights of each sub-pixel phase
+}InterpWeights;
+
+typedef struct 
+{
+	uint8_t Kernel;
+	uint16_t InWidth;
+	uint16_t InHeight;
+	uint16_t OutWidth;
+	uint16_t OutHeight;
+	uint32_t ColStart;             //Source coordinate of the first output column (Q16)
+	uint32_t ColStep;              //Source coordinate increment per output column (Q16)
+	uint32_t RowStart;
+	uint32_t RowStep;
+	const InterpWeights *Weights;  //Bicubic weight table, NULL for the other kernels
+}InterpEngine;                     //Read-only after InterpInit(), may be shared by several configurations
+
+/*Temporal Otus threshold estimator: keeps the histogram of the previous frame and updates it 
+  with the pixels that changed*/
+typedef struct 
+{
+	uint16_t GrayNum[MaxGrayscale];
+	uint32_t Occupied[MaxGrayscale / 32];  //Bit set for every gray level with pixels
+	uint32_t GraySum;              //Sum of the gray levels of the frame
+	uint8_t  PrevMat[MaxInPixels];
+	uint16_t TotalPixels;          //0 until the first frame has been counted
+	uint8_t  Threshold;
+}OtusTracker;
+
+/*Automatic gain control: smooths the mapped temperature range and the equalization curve 
+  from frame to frame so a single hot pixel or a change of scene does not make the colours flicker*/
+typedef struct 
+{
+	uint8_t  Mode;                 //AgcSmoothRange and/or AgcEqualize
+	uint8_t  SmoothShift;          //Smoothing time constant of about 2^SmoothShift frames (0 ~ 8, 0: no smoothing)
+	uint8_t  Plateau;              //Clip limit of one histogram bin in 1/256 of the pixels (0: no clipping)
+	uint8_t  Primed;               //Mode bits whose state has been seeded by a first frame
+	int32_t  RangeMax;             //Smoothed maximum temperature (1/256 degC units)
+	int32_t  RangeMin;             //Smoothed minimum temperature (1/256 degC units)
+	uint16_t Curve[MaxGrayscale];  //Smoothed equalization curve (1/256 gray level units)
+	uint8_t  Lut[MaxGrayscale];    //Equalization curve of the last frame, rounded to gray levels
+}AutoGain;
+
+/*Multi-frame super-resolution: registers the global sub-pixel shift of every frame against the 
+  previous one and accumulates the samples into a Scale times finer grid with an exponential window*/
+typedef struct 
+{
+	uint16_t InWidth;
+	uint16_t InHeight;
+	uint8_t  Scale;                //Grid cells per input pixel in each direction
+	uint8_t  WindowShift;          //Window length is about 2^WindowShift frames (0 ~ 6)
+	uint8_t  Frames;               //Frames accumulated since the last re-anchor, saturates at 255
+	int16_t  ShiftX;               //Shift of the last frame against the reference (1/256 pixel)
+	int16_t  ShiftY;
+	int16_t  PrevMat[MaxInPixels];     //Previous frame (0.25 degC units)
+	int32_t  Mean[MaxSuperResPixels];  //Weighted mean of every grid cell (1/64 degC units)
+	uint16_t Weight[MaxSuperResPixels];//Sample weight of every grid cell, 16 per sample
+}SuperResolution;
+
+/*Temperature band highlighted on the output image*/
+typedef struct 
+{
+	float TempLow;                 //Lower edge of the band (unit: degC)
+	float TempHigh;                //Upper edge of the band (unit: degC)
+	unsigned int Color;            //RGB565 colour of the band in PixelRGB565 output
+	uint8_t Gray;                  //Gray value of the band in PixelGray8 output
+}IsothermBand;
+
+/*Isotherm and alarm-band overlay: the bands are folded into the palette (or a gray mapping) 
+  of every frame, so the pixels are marked while they are produced*/
+typedef struct 
+{
+	uint8_t Count;                 //Bands in use (0 ~ MaxIsotherms), a later band is drawn over an earlier one
+	IsothermBand Band[MaxIsotherms];
+	unsigned int Palette[MaxGrayscale];  //Palette of the current frame with the bands marked, built by the pipeline
+	uint8_t GrayMap[MaxGrayscale];       //Gray mapping of the current frame with the bands marked, built by the pipeline
+}IsothermOverlay;
+
+/*Receives one output row in stream mode: Row index, OutWidth pixels (uint8_t gray or uint16_t RGB565), user argument*/
+typedef void (*ThermalImagingRowSink)(uint16_t Row,void *RowMat,uint16_t Width,void *Arg);
+
+/*Imaging context: every configuration carries its own temperature range and tables, and all 
+  scratch memory of the pipeline is on the stack, so several configurations (e.g. one per sensor) 
+  can be processed concurrently or interleaved*/
 typedef struct 
 {
 	float *InMat;
-	uint8_t *OutMat;
-	uint8_t InWidth;
-	uint8_t InHeight;
-	uint8_t OutWidth;
-	uint8_t OutHeight;
+	void *OutMat;                  //Output matrix in PixelFormat, or a buffer of one output row in stream mode
+	uint16_t InWidth;
+	uint16_t InHeight;
+	uint16_t OutWidth;
+	uint16_t OutHeight;
 	uint8_t  Background;	
+	uint8_t Neighbors;             //Neighbourhood of the fused background suppression, Neighbors4 (default) or Neighbors8
 	uint8_t TempDiff;
+	float TempMax;                 //Maximum value of InMat
+	float TempMin;                 //Minimum value of InMat
+	uint8_t PixelFormat;           //PixelGray8 or PixelRGB565
+	const unsigned int *Palette;   //256-entry RGB565 palette used by PixelRGB565 (e.g. Rainbow2_65K)
+	BilinearTable *Table;          //Optional precomputed interpolation tables, NULL to use Bilinear()
+	InterpEngine *Engine;          //Optional separable interpolation engine, takes precedence over Table
+	OtusTracker *Tracker;          //Optional temporal threshold estimator used by the fused pipeline, NULL to recount every frame
+	AutoGain *Gain;                //Optional automatic gain control used by the fused pipeline, NULL for the linear TempMin..TempMax mapping
+	IsothermOverlay *Overlay;      //Optional isotherm bands marked on the output, NULL for none; its tables are rebuilt every frame, so one per configuration
 }ThermalImagingConfig;
 
+/*Frames of several sensors with one geometry and one engine: per-frame data are arrays 
+  indexed by frame, and the settings are shared by the whole batch*/
+typedef struct 
+{
+	uint16_t Frames;
+	float *InMat;                  //Frames * InWidth * InHeight temperatures, frame after frame
+	float *TempMax;                //Maximum value of every frame
+	float *TempMin;                //Minimum value of every frame
+	void *OutMat;                  //Frames * OutWidth * OutHeight pixels in PixelFormat, frame after frame
+	uint8_t *Status;               //Optional result of every frame, 0: imaged  1: temperature difference too small, output untouched
+	OtusTracker *Tracker;          //Optional array of Frames threshold estimators, one per sensor
+	AutoGain *Gain;                //Optional array of Frames automatic gain controls, one per sensor
+	IsothermOverlay *Overlay;      //Optional array of Frames isotherm overlays, one per sensor
+	uint16_t InWidth;
+	uint16_t InHeight;
+	uint16_t OutWidth;
+	uint16_t OutHeight;
+	uint8_t  Background;
+	uint8_t Neighbors;
+	uint8_t TempDiff;
+	uint8_t PixelFormat;           //PixelGray8 or PixelRGB565
+	const unsigned int *Palette;   //256-entry RGB565 palette used by PixelRGB565
+	InterpEngine *Engine;          //Separable interpolation engine shared by every frame
+}ThermalImagingBatch;
+
 
 
 /* Exported functions --------------------------------------------------------------------------------------*/
 uint8_t InfraredThermalImaging(ThermalImagingConfig *Config);
-uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight,uint8_t OutWidth,uint8_t OutHeight);
-uint8_t TransformGray(float *InMat,uint8_t *OutMat,uint8_t InWidth,uint8_t InHeight,float Max,float Min);
-uint8_t  Otus(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight);
-uint8_t BackgroundFiltering(uint8_t *InMat,uint8_t InWidth,uint8_t InHeight,uint8_t Threshold,uint8_t Background);
+uint8_t InfraredThermalImagingFused(ThermalImagingConfig *Config);
+uint8_t InfraredThermalImagingStream(ThermalImagingConfig *Config,ThermalImagingRowSink Sink,void *Arg);
+uint8_t InfraredThermalImagingPrepare(ThermalImagingConfig *Config,uint8_t *GrayMat);
+uint8_t InfraredThermalImagingTile(ThermalImagingConfig *Config,uint8_t *GrayMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight);
+uint8_t InfraredThermalImagingBatch(ThermalImagingBatch *Batch);
+uint8_t Bilinear(uint8_t *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight);
+uint8_t BilinearInit(BilinearTable *Table,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight);
+uint8_t BilinearFast(BilinearTable *Table,uint8_t *InMat,uint8_t *OutMat);
+uint8_t InterpInit(InterpEngine *Engine,uint8_t Kernel,InterpWeights *Weights,uint16_t InWidth,uint16_t InHeight,uint16_t OutWidth,uint16_t OutHeight);
+uint8_t InterpRun(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutMat);
+uint8_t InterpRunStream(InterpEngine *Engine,uint8_t *InMat,void *RowMat,const unsigned int *Palette,ThermalImagingRowSink Sink,void *Arg);
+uint8_t InterpRunTile(InterpEngine *Engine,uint8_t *InMat,uint8_t *OutMat,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight);
+uint8_t InterpRunTileColor(InterpEngine *Engine,uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint16_t xStart,uint16_t yStart,uint16_t TileWidth,uint16_t TileHeight);
+uint8_t SuperResInit(SuperResolution *SuperRes,uint16_t InWidth,uint16_t InHeight,uint8_t Scale,uint8_t WindowShift);
+uint8_t SuperResUpdate(SuperResolution *SuperRes,float *InMat,float *OutMat);
+uint8_t TransformGray(float *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,float Max,float Min);
+uint8_t TransformGrayFixed(int16_t *InMat,uint8_t *OutMat,uint16_t InWidth,uint16_t InHeight,int16_t Max,int16_t Min);
+uint8_t DecodeRawPixels(uint8_t *Bytes,int16_t *RawMat,uint16_t Pixels);
+uint8_t PaletteMap(uint8_t *InMat,uint16_t *OutColor,const unsigned int *Palette,uint32_t Pixels);
+uint8_t SimdSelect(uint8_t Level);
+uint8_t  Otus(uint8_t *InMat,uint16_t InWidth,uint16_t InHeight);
+uint8_t OtusHistogram(uint16_t *GrayNum,unsigned int TotalPixels);
+uint8_t OtusHistogramFloat(uint16_t *GrayNum,unsigned int TotalPixels);
+void OtusTrackerInit(OtusTracker *Tracker);
+uint8_t OtusTrackerUpdate(OtusTracker *Tracker,uint8_t *InMat,uint16_t InWidth,uint16_t InHeight);
+void AutoGainInit(AutoGain *Gain,uint8_t Mode,uint8_t SmoothShift,uint8_t Plateau);
+uint8_t AutoGainRange(AutoGain *Gain,float *Max,float *Min);
+uint8_t AutoGainEqualize(AutoGain *Gain,uint16_t *GrayNum,unsigned int TotalPixels);
+uint8_t IsothermBuild(IsothermOverlay *Overlay,uint8_t PixelFormat,const unsigned int *Palette,float Max,float Min,const uint8_t *Lut);
+uint8_t BackgroundFiltering(uint8_t *InMat,uint16_t InWidth,uint16_t InHeight,uint8_t Threshold,uint8_t Background);
+uint8_t BackgroundSuppress(uint8_t *SrcMat,uint8_t *DstMat,uint16_t Width,uint16_t Height,uint8_t Threshold,uint8_t Background,uint8_t Neighbors);
 
 #endif 
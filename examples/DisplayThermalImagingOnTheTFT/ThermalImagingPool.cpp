@@ -0,0 +1,302 @@
+/*****************************************************************
+File:             ThermalImagingPool.cpp
+Author:           BESTMODULE
+Description:      Work-stealing pool of imaging workers for host builds. Not compiled for Arduino.
+History：
+V1.0.1   -- initial version；2026-10-19；C++11
+******************************************************************/
+#if !defined(ARDUINO)
+#include <string.h>
+#include "ThermalImagingPool.h"
+
+/**********************************************************
+Description: Constructor, starts the workers
+Parameters:  sink: Receives every imaged frame
+             arg: User argument passed to sink
+             workers: Number of worker threads, 0: one per hardware thread
+             queueDepth: Frames that may wait for each sensor before submit() refuses new ones
+Return:      none
+Others:      The SIMD level is chosen here, before any worker runs the pipeline.
+**********************************************************/
+ThermalImagingPool::ThermalImagingPool(ThermalImagingPoolSink sink, void *arg, unsigned workers, uint8_t queueDepth)
+    : _sink(sink), _arg(arg), _queueDepth(queueDepth == 0 ? 1 : queueDepth),
+      _queued(0), _pending(0), _dropped(0), _stop(false)
+{
+      if(workers == 0) workers = std::thread::hardware_concurrency();
+      if(workers == 0) workers = 1;
+      SimdSelect(SimdAuto);
+      for(unsigned i = 0; i < workers; i++)
+      {
+          _workers.push_back(new Worker());
+          memset(&_workers[i]->stats, 0, sizeof(ThermalImagingPoolStats));
+      }
+      for(unsigned i = 0; i < workers; i++)
+      {
+          _workers[i]->thread = std::thread(&ThermalImagingPool::run, this, i);
+      }
+}
+/**********************************************************
+Description: Destructor, delivers the queued frames and stops the workers
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+ThermalImagingPool::~ThermalImagingPool()
+{
+      drain();
+      _stop = true;
+      {
+          std::lock_guard<std::mutex> guard(_idleLock);
+      }
+      _wake.notify_all();
+      //Idle workers still look into each other's deques, so join them all before freeing any
+      for(size_t i = 0; i < _workers.size(); i++) _workers[i]->thread.join();
+      for(size_t i = 0; i < _workers.size(); i++) delete _workers[i];
+      for(size_t i = 0; i < _sensors.size(); i++) delete _sensors[i];
+}
+/**********************************************************
+Description: Register a sensor
+Parameters:  config: Imaging configuration of the sensor (geometry, OutMat, Engine,
+                     Tracker, Gain...), InMat/TempMax/TempMin are ignored
+Return:      Sensor number to pass to submit(), -1: geometry exceeds MaxInPixels
+Others:      The configuration is copied. OutMat, Tracker, Gain and Overlay must
+             belong to this sensor only (the pipeline rebuilds the palette of the
+             Overlay every frame); the Engine and the Palette may be shared.
+**********************************************************/
+int ThermalImagingPool::addSensor(const ThermalImagingConfig &config)
+{
+      if((uint32_t)config.InWidth * config.InHeight > MaxInPixels) return -1;
+      std::lock_guard<std::mutex> guard(_sensorsLock);
+      Sensor *sensor = new Sensor();
+      sensor->id = _sensors.size();
+      sensor->config = config;
+      sensor->config.InMat = sensor->work;
+      sensor->scheduled = false;
+      sensor->nextSequence = 0;
+      _sensors.push_back(sensor);
+      return sensor->id;
+}
+/**********************************************************
+Description: Queue one frame of a sensor for imaging
+Parameters:  sensor: Sensor number returned by addSensor()
+             tempMat[]: Temperature data of the frame (InWidth * InHeight, unit:℃), copied
+             tempMax: Maximum value of tempMat
+             tempMin: Minimum value of tempMat
+Return:      true: queued  false: unknown sensor or its queue is full (frame dropped)
+Others:      Frames of one sensor are imaged one after another and delivered in
+             submission order, frames of different sensors run in parallel.
+**********************************************************/
+bool ThermalImagingPool::submit(uint16_t sensor, const float tempMat[], float tempMax, float tempMin)
+{
+      Sensor *target;
+      bool wake = false;
+
+      {
+          std::lock_guard<std::mutex> guard(_sensorsLock);
+          if(sensor >= _sensors.size()) return false;
+          target = _sensors[sensor];
+      }
+      {
+          std::lock_guard<std::mutex> guard(target->lock);
+          if(target->frames.size() >= _queueDepth)
+          {
+              _dropped++;
+              return false;
+          }
+          target->frames.push_back(Frame());
+          Frame &frame = target->frames.back();
+          memcpy(frame.tempMat, tempMat, (uint32_t)target->config.InWidth * target->config.InHeight * sizeof(float));
+          frame.tempMax = tempMax;
+          frame.tempMin = tempMin;
+          frame.sequence = target->nextSequence++;
+          frame.submitted = Clock::now();
+          _pending++;
+          if(!target->scheduled)
+          {
+              target->scheduled = true;
+              wake = true;
+          }
+      }
+      if(wake) schedule(target, target->id % _workers.size());
+      return true;
+}
+/**********************************************************
+Description: Wait until every submitted frame has been delivered
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+void ThermalImagingPool::drain()
+{
+      std::unique_lock<std::mutex> guard(_idleLock);
+      _idle.wait(guard, [this]{ return _pending == 0; });
+}
+/**********************************************************
+Description: Latency of every stage since the start or the last clearStats()
+Parameters:  stats: Store the sum over all workers
+Return:      none
+Others:      none
+**********************************************************/
+void ThermalImagingPool::getStats(ThermalImagingPoolStats &stats)
+{
+      memset(&stats, 0, sizeof(stats));
+      for(size_t i = 0; i < _workers.size(); i++)
+      {
+          std::lock_guard<std::mutex> guard(_workers[i]->lock);
+          for(uint8_t s = 0; s < PoolStages; s++)
+          {
+              ThermalImagingPoolStage &from = _workers[i]->stats.stage[s];
+              stats.stage[s].count   += from.count;
+              stats.stage[s].totalUs += from.totalUs;
+              if(from.maxUs > stats.stage[s].maxUs) stats.stage[s].maxUs = from.maxUs;
+          }
+          stats.stolen += _workers[i]->stats.stolen;
+      }
+      stats.dropped = _dropped;
+}
+/**********************************************************
+Description: Reset the latency statistics
+Parameters:  none
+Return:      none
+Others:      none
+**********************************************************/
+void ThermalImagingPool::clearStats()
+{
+      for(size_t i = 0; i < _workers.size(); i++)
+      {
+          std::lock_guard<std::mutex> guard(_workers[i]->lock);
+          memset(&_workers[i]->stats, 0, sizeof(ThermalImagingPoolStats));
+      }
+      _dropped = 0;
+}
+/**********************************************************
+Description: Worker thread
+Parameters:  self: Index of the worker
+Return:      none
+Others:      A task is a sensor with waiting frames. The worker images one frame
+             of it and, if more are waiting, puts it back on its own deque, so
+             busy sensors share the workers fairly and a sensor is never run
+             by two workers at once.
+**********************************************************/
+void ThermalImagingPool::run(unsigned self)
+{
+      Worker &worker = *_workers[self];
+      Frame frame;
+      bool stolen,again;
+
+      while(true)
+      {
+          Sensor *sensor = take(self, stolen);
+          if(sensor == NULL)
+          {
+              std::unique_lock<std::mutex> guard(_idleLock);
+              _wake.wait(guard, [this]{ return _queued > 0 || _stop; });
+              if(_stop && _queued == 0) return;
+              continue;
+          }
+          {
+              std::lock_guard<std::mutex> guard(sensor->lock);
+              frame = sensor->frames.front();
+              sensor->frames.pop_front();
+          }
+
+          Clock::time_point start = Clock::now();
+          memcpy(sensor->work, frame.tempMat, (uint32_t)sensor->config.InWidth * sensor->config.InHeight * sizeof(float));
+          sensor->config.TempMax = frame.tempMax;
+          sensor->config.TempMin = frame.tempMin;
+          uint8_t result = InfraredThermalImagingFused(&sensor->config);
+          Clock::time_point imaged = Clock::now();
+          if(_sink != NULL) _sink(sensor->id, frame.sequence, result, &sensor->config, _arg);
+          Clock::time_point delivered = Clock::now();
+
+          {
+              std::lock_guard<std::mutex> guard(worker.lock);
+              record(worker, PoolStageQueue, frame.submitted, start);
+              record(worker, PoolStageImaging, start, imaged);
+              record(worker, PoolStageSink, imaged, delivered);
+              if(stolen) worker.stats.stolen++;
+          }
+          {
+              std::lock_guard<std::mutex> guard(sensor->lock);
+              again = !sensor->frames.empty();
+              if(!again) sensor->scheduled = false;
+          }
+          if(again) schedule(sensor, self);
+          if(--_pending == 0)
+          {
+              std::lock_guard<std::mutex> guard(_idleLock);
+              _idle.notify_all();
+          }
+      }
+}
+/**********************************************************
+Description: Next task of a worker
+Parameters:  self: Index of the worker
+             stolen: Set when the task came from another worker
+Return:      Sensor to run, NULL: every deque is empty
+Others:      The own deque is served oldest first, other deques are robbed from
+             the newest end to keep away from their owner.
+**********************************************************/
+ThermalImagingPool::Sensor *ThermalImagingPool::take(unsigned self, bool &stolen)
+{
+      Sensor *sensor = NULL;
+      size_t count = _workers.size();
+
+      for(size_t i = 0; i < count && sensor == NULL; i++)
+      {
+          Worker &victim = *_workers[(self + i) % count];
+          std::lock_guard<std::mutex> guard(victim.lock);
+          if(victim.tasks.empty()) continue;
+          if(i == 0)
+          {
+              sensor = victim.tasks.front();
+              victim.tasks.pop_front();
+          }
+          else
+          {
+              sensor = victim.tasks.back();
+              victim.tasks.pop_back();
+          }
+          stolen = i != 0;
+      }
+      if(sensor != NULL) _queued--;
+      return sensor;
+}
+/**********************************************************
+Description: Queue a sensor task on a worker and wake an idle worker
+Parameters:  sensor: Sensor with waiting frames
+             worker: Index of the worker deque
+Return:      none
+Others:      none
+**********************************************************/
+void ThermalImagingPool::schedule(Sensor *sensor, unsigned worker)
+{
+      _queued++;
+      {
+          std::lock_guard<std::mutex> guard(_workers[worker]->lock);
+          _workers[worker]->tasks.push_back(sensor);
+      }
+      {
+          std::lock_guard<std::mutex> guard(_idleLock);
+      }
+      _wake.notify_one();
+}
+/**********************************************************
+Description: Add one latency to the statistics of a worker
+Parameters:  worker: Worker whose statistics are updated, locked by the caller
+             stage: PoolStageQueue, PoolStageImaging or PoolStageSink
+             start: Start of the stage
+             end: End of the stage
+Return:      none
+Others:      none
+**********************************************************/
+void ThermalImagingPool::record(Worker &worker, uint8_t stage, Clock::time_point start, Clock::time_point end)
+{
+      uint32_t us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+      ThermalImagingPoolStage &entry = worker.stats.stage[stage];
+
+      entry.count++;
+      entry.totalUs += us;
+      if(us > entry.maxUs) entry.maxUs = us;
+}
+#endif
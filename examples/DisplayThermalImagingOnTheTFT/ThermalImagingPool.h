@@ -0,0 +1,109 @@
+/*****************************************************************
+File:             ThermalImagingPool.h
+Author:           BESTMODULE
+Description:      Work-stealing pool of imaging workers for host builds (e.g. a Linux
+                  gateway reading many BMS26M833 sensors). Not compiled for Arduino.
+History：
+V1.0.1   -- initial version；2026-10-19；C++11
+******************************************************************/
+#ifndef _THERMALIMAGINGPOOL_H_
+#define _THERMALIMAGINGPOOL_H_
+#if !defined(ARDUINO)
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C" {
+  #include "InfraredThermalImaging.h"
+}
+
+/*Pipeline stages whose latency is reported*/
+#define PoolStageQueue   0          //submit() until a worker starts the frame
+#define PoolStageImaging 1          //InfraredThermalImagingFused()
+#define PoolStageSink    2          //Sink callback
+#define PoolStages       3
+
+/*Receives every imaged frame, in submission order for each sensor, on a worker thread.
+  Config -> OutMat holds the image until the callback returns*/
+typedef void (*ThermalImagingPoolSink)(uint16_t sensor, uint32_t sequence, uint8_t result, ThermalImagingConfig *config, void *arg);
+
+typedef struct
+{
+    uint32_t count;                 //Frames through the stage
+    uint64_t totalUs;               //Sum of the latencies (unit:us)
+    uint32_t maxUs;                 //Largest latency (unit:us)
+}ThermalImagingPoolStage;
+
+typedef struct
+{
+    ThermalImagingPoolStage stage[PoolStages];
+    uint32_t dropped;               //Frames refused because the queue of their sensor was full
+    uint32_t stolen;                //Sensor tasks run by a worker other than the one they were queued on
+}ThermalImagingPoolStats;
+
+class ThermalImagingPool
+{
+   public:
+        ThermalImagingPool(ThermalImagingPoolSink sink, void *arg = NULL, unsigned workers = 0, uint8_t queueDepth = 4);
+        ~ThermalImagingPool();
+        int addSensor(const ThermalImagingConfig &config);
+        bool submit(uint16_t sensor, const float tempMat[], float tempMax, float tempMin);
+        void drain();
+        void getStats(ThermalImagingPoolStats &stats);
+        void clearStats();
+
+   private:
+        typedef std::chrono::steady_clock Clock;
+        struct Frame
+        {
+            float tempMat[MaxInPixels];
+            float tempMax;
+            float tempMin;
+            uint32_t sequence;
+            Clock::time_point submitted;
+        };
+        struct Sensor
+        {
+            uint16_t id;
+            ThermalImagingConfig config;    //Private copy, InMat points to work[]
+            float work[MaxInPixels];
+            std::mutex lock;
+            std::deque<Frame> frames;       //Waiting frames, oldest first
+            bool scheduled;                 //Queued on or run by exactly one worker
+            uint32_t nextSequence;
+        };
+        struct Worker
+        {
+            std::mutex lock;
+            std::deque<Sensor *> tasks;
+            ThermalImagingPoolStats stats;
+            std::thread thread;
+        };
+
+        void run(unsigned self);
+        Sensor *take(unsigned self, bool &stolen);
+        void schedule(Sensor *sensor, unsigned worker);
+        void record(Worker &worker, uint8_t stage, Clock::time_point start, Clock::time_point end);
+
+        ThermalImagingPoolSink _sink;
+        void *_arg;
+        uint8_t _queueDepth;
+        std::vector<Sensor *> _sensors;
+        std::vector<Worker *> _workers;
+        std::mutex _sensorsLock;
+        std::mutex _idleLock;
+        std::condition_variable _wake;      //A task was queued or the pool stops
+        std::condition_variable _idle;      //A frame finished, for drain()
+        std::atomic<uint32_t> _queued;      //Sensor tasks waiting in the worker deques
+        std::atomic<uint32_t> _pending;     //Frames submitted and not yet delivered
+        std::atomic<uint32_t> _dropped;
+        std::atomic<bool> _stop;
+};
+
+#endif
+#endif
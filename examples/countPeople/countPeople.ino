@@ -0,0 +1,60 @@
+/*****************************************************************
+File:         countPeople.ino
+Description:  Count the people walking through a doorway under a ceiling-mounted 
+              sensor. The warm blobs of every frame are labelled, followed from 
+              frame to frame and counted when they cross a virtual line across 
+              the doorway. The counters are printed on the serial port whenever 
+              they change.
+******************************************************************/
+#include <BMS26M833.h>
+#include <ThermalAnalytics.h>
+
+#define TEMP_BODY      26       //Pixels above this temperature are taken as people (unit:℃)
+#define LINE_COLUMN    896      //Virtual line between columns 3 and 4, In counts people walking to the right (unit:1/256 pixel)
+#define LINE_BAND      128      //Half width of the dead band around the line (unit:1/256 pixel)
+
+BMS26M833 Amg;
+int16_t RawMat[64];
+int16_t RawMax,RawMin;
+BlobList People;
+ObjectTracker Tracker;
+LineCounter Door;
+
+void setup() 
+{
+    Serial.begin(9600);
+    Amg.begin();
+    Amg.setFrameMode(FPS_10);
+    ObjectTrackerInit(&Tracker, 512, 2, 2);     //Half a metre or so between frames, seen twice before counted, lost for 2 frames at most
+    LineCounterInit(&Door, LINE_COLUMN, 1792, LINE_COLUMN, 0, LINE_BAND);
+    Serial.println("======== BMS26M833 people counter ========");
+}
+
+void loop() 
+{
+    Amg.readRawPixelsAndMaximum(RawMat, RawMax, RawMin);
+    if(CountFrame() != 0)
+    {
+        Serial.print("In: ");
+        Serial.print(Door.In);
+        Serial.print("  Out: ");
+        Serial.print(Door.Out);
+        Serial.print("  In view: ");
+        Serial.println(People.Count);
+    }
+    delay(100);
+}
+
+/**********************************************************
+Description: Run the counting stages on RawMat
+Parameters:  none
+Return:      Crossings counted in this frame
+Others:      none
+**********************************************************/
+uint8_t CountFrame()
+{
+    BlobLabel(RawMat, NULL, TEMP_BODY * 4, Neighbors4, 2, &People);
+    ObjectTrackerUpdate(&Tracker, &People);
+    return LineCounterUpdate(&Door, &Tracker);
+}
+
@@ -0,0 +1,49 @@
+/*****************************************************************
+File:         setInterruptMap.ino
+Description:  This sketch gives every zone of the 8*8 pixels its own alarm 
+              temperature. The sensor interrupt is set to the loosest of them, 
+              so the pixels are only read and checked while it is asserted.
+              The pixels in alarm are printed out from the serial port.
+******************************************************************/
+#include <BMS26M833.h>
+
+//alarm levels (in degrees C, Resolution is 0.25℃)
+#define TEMP_ALARM_LEFT   30     //columns 0~3, e.g. a hand waved in front of the sensor
+#define TEMP_ALARM_RIGHT  45     //columns 4~7, e.g. a heater that is normally warm
+#define TEMP_HYSTERESIS   1      //an alarm clears 1 degree C below its level
+
+BMS26M833 Amg;
+ThresholdMap Alarms;
+int16_t RawMat[64];
+
+void setup() 
+{
+    Serial.begin(9600);
+    Amg.begin();
+    ThresholdMapInit(&Alarms, TEMP_ALARM_LEFT * 4, ThresholdLowOff, TEMP_HYSTERESIS * 4);
+    for(int i = 0; i < 64; i++)
+    {
+        if(i % 8 >= 4) Alarms.High[i] = TEMP_ALARM_RIGHT * 4;
+    }
+    Amg.setInterruptLevels(Alarms);
+    Amg.setINT(true);
+}
+
+void loop() 
+{
+    if(Amg.readPixelAlarms(Alarms, RawMat) > 0)
+    {
+        Serial.println("=======Pixels in alarm=======");
+        for(int i = 0; i < 8; i++)
+        {
+            for(int j = 0; j < 8; j++)
+            {
+                bool alarmBit = Alarms.Alarm[i] & (1 << j);
+                Serial.print(alarmBit);
+                Serial.print(" ");
+            }
+            Serial.println();
+        }
+    }
+    delay(100);
+}
@@ -0,0 +1,23 @@
+/*****************************************************************
+File:             check.h
+Author:           BESTMODULES
+Description:      Minimal checks for the host tests of extras/test, no framework needed.
+History：
+V1.0.1   -- initial version；2026-10-19
+******************************************************************/
+#ifndef _CHECK_H_
+#define _CHECK_H_
+#include <stdio.h>
+
+static unsigned CheckFailures = 0;
+
+/*Report a failed condition with its position, the test goes on*/
+#define CHECK(Cond) do { if(!(Cond)) { printf("%s:%d: CHECK(%s) failed\n",__FILE__,__LINE__,#Cond); CheckFailures++; } } while(0)
+
+/*Run one test function and print its name*/
+#define RUN(Test) do { unsigned Before = CheckFailures; Test(); printf("%-32s %s\n",#Test,CheckFailures == Before ? "ok" : "FAILED"); } while(0)
+
+/*Exit code of main()*/
+#define CHECK_RESULT() (CheckFailures == 0 ? 0 : 1)
+
+#endif
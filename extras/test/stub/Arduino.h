@@ -0,0 +1,22 @@
+/*****************************************************************
+File:             Arduino.h
+Description:      Host stand-in for the parts of the Arduino core the library uses,
+                  for the tests in extras/test only.
+******************************************************************/
+#ifndef _ARDUINO_STUB_H_
+#define _ARDUINO_STUB_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define INPUT    0
+#define OUTPUT   1
+#define LOW      0
+#define HIGH     1
+
+static inline void delay(unsigned long) {}
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline int digitalRead(uint8_t) { return HIGH; }
+
+#endif
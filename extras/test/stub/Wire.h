@@ -0,0 +1,39 @@
+/*****************************************************************
+File:             Wire.h
+Description:      Host stand-in for TwoWire: a register file the tests fill, read
+                  and written from the address sent first, as the BMS26M833 does.
+******************************************************************/
+#ifndef _WIRE_STUB_H_
+#define _WIRE_STUB_H_
+#include <Arduino.h>
+
+class TwoWire
+{
+    public:
+        uint8_t Regs[256];
+        void begin() {}
+        void beginTransmission(uint8_t) { _first = 1; }
+        size_t write(const uint8_t *data, size_t len)
+        {
+            for(size_t i = 0; i < len; i++)
+            {
+                if(_first) _pos = data[i];
+                else Regs[_pos++] = data[i];
+                _first = 0;
+            }
+            return len;
+        }
+        size_t write(uint8_t data) { return write(&data, 1); }
+        uint8_t endTransmission() { return 0; }
+        uint8_t requestFrom(uint8_t, uint8_t len) { _left = len; return len; }
+        int available() { return _left; }
+        int read() { if(_left == 0) return -1; _left--; return Regs[_pos++]; }
+    private:
+        uint8_t _pos = 0;
+        uint8_t _left = 0;
+        uint8_t _first = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
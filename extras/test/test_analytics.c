@@ -0,0 +1,418 @@
+/*****************************************************************
+File:             test_analytics.c
+Author:           BESTMODULES
+Description:      Host tests of ThermalAnalytics on synthetic 8*8 scenes: blob labelling,
+                  tracking, line counting, background model, threshold map and rate of rise.
+History：
+V1.0.1   -- initial version；2026-10-19
+******************************************************************/
+#include <stdlib.h>
+#include "ThermalAnalytics.h"
+#include "check.h"
+
+#define FLOOR  (22 * 4)          //Background temperature of the scenes (unit:0.25℃)
+
+/*Person walking along a row of the scene*/
+typedef struct
+{
+  uint16_t Start;                //First frame
+  uint8_t Row;
+  int16_t Speed;                 //Columns per frame, positive: to the right (unit:1/256 pixel)
+}Walker;
+
+/*Noise of -2 ~ +2 raw steps, the same on every run*/
+static int16_t Noise(void)
+{
+  return (int16_t)(rand() % 3 - 1 + rand() % 3 - 1);
+}
+
+/*Draw one frame of a corridor: a warm spot 1.5 pixels across for every walker in view*/
+static void DrawCorridor(int16_t *RawMat,const Walker *Walkers,uint8_t Count,uint16_t Frame)
+{
+  int16_t x,dx,dy;
+  uint16_t d2;
+  uint8_t i,w;
+
+  for(i = 0; i < FramePixels; i++) RawMat[i] = FLOOR + Noise();
+  for(w = 0; w < Count; w++)
+  {
+    if(Frame < Walkers[w].Start) continue;
+    x = (Walkers[w].Speed > 0 ? -384 : 2176) + (int16_t)(Frame - Walkers[w].Start) * Walkers[w].Speed;
+    if(x < -384 || x > 2176) continue;
+    for(i = 0; i < FramePixels; i++)
+    {
+      dx = ((i & 7) * 256 - x) / 16;
+      dy = ((i >> 3) - Walkers[w].Row) * 16;
+      if(dx < -24 || dx > 24 || dy < -24 || dy > 24) continue;
+      d2 = dx * dx + dy * dy;
+      if(d2 < 576) RawMat[i] += 48 - d2 / 12;
+    }
+  }
+}
+
+/*Flood fill reference labelling*/
+static void FloodLabel(const uint8_t *Mask,uint8_t Neighbors,int8_t *Label,uint8_t *Area,uint8_t *Count)
+{
+  uint8_t Stack[FramePixels];
+  uint8_t Top,p,q,i;
+  int8_t dx,dy,nx,ny;
+
+  *Count = 0;
+  for(i = 0; i < FramePixels; i++) Label[i] = -1;
+  for(i = 0; i < FramePixels; i++)
+  {
+    if(!Mask[i] || Label[i] >= 0) continue;
+    Area[*Count] = 0;
+    Top = 0;
+    Stack[Top++] = i;
+    Label[i] = *Count;
+    while(Top > 0)
+    {
+      p = Stack[--Top];
+      Area[*Count]++;
+      for(dy = -1; dy <= 1; dy++)
+      {
+        for(dx = -1; dx <= 1; dx++)
+        {
+          if((dx == 0 && dy == 0) || (Neighbors == Neighbors4 && dx != 0 && dy != 0)) continue;
+          nx = (p & 7) + dx;
+          ny = (p >> 3) + dy;
+          if(nx < 0 || nx > 7 || ny < 0 || ny > 7) continue;
+          q = ny * 8 + nx;
+          if(Mask[q] && Label[q] < 0)
+          {
+            Label[q] = *Count;
+            Stack[Top++] = q;
+          }
+        }
+      }
+    }
+    (*Count)++;
+  }
+}
+
+/*BlobLabel() agrees with a flood fill on random masks, for both connectivities*/
+static void TestBlobLabel(void)
+{
+  BlobList List;
+  int16_t RawMat[FramePixels];
+  uint8_t Mask[FramePixels],Area[FramePixels];
+  int8_t Label[FramePixels];
+  uint8_t Count,Kept,Neighbors,MinArea,Density,i,k;
+  int32_t SumX,SumY;
+  int16_t Peak;
+  uint32_t Run;
+
+  srand(1);
+  for(Run = 0; Run < 20000; Run++)
+  {
+    Density = rand() % 100;
+    Neighbors = rand() & 1 ? Neighbors8 : Neighbors4;
+    MinArea = rand() % 3;
+    for(i = 0; i < FramePixels; i++)
+    {
+      RawMat[i] = rand() % 400 - 100;
+      Mask[i] = rand() % 100 < Density;
+    }
+    CHECK(BlobLabel(RawMat,Mask,0,Neighbors,MinArea,&List) == 0);
+    FloodLabel(Mask,Neighbors,Label,Area,&Count);
+    for(Kept = 0,k = 0; k < Count; k++) Kept += Area[k] >= MinArea;
+    CHECK(List.Count == Kept);
+    for(k = 0; k < List.Count; k++)
+    {
+      const ThermalBlob *Blob = &List.Blob[k];
+      int8_t Id = Label[Blob->PeakIndex];
+      uint8_t Left = 7,Right = 0,Top = 7,Bottom = 0;
+      CHECK(Id >= 0 && Area[Id] == Blob->Area);
+      if(k > 0) CHECK(List.Blob[k - 1].Area >= Blob->Area);
+      SumX = SumY = 0;
+      Peak = -32768;
+      for(i = 0; i < FramePixels; i++)
+      {
+        if(Label[i] != Id) continue;
+        SumX += i & 7;
+        SumY += i >> 3;
+        if((i & 7) < Left) Left = i & 7;
+        if((i & 7) > Right) Right = i & 7;
+        if((i >> 3) < Top) Top = i >> 3;
+        if((i >> 3) > Bottom) Bottom = i >> 3;
+        if(RawMat[i] > Peak) Peak = RawMat[i];
+      }
+      CHECK(Blob->Left == Left && Blob->Right == Right && Blob->Top == Top && Blob->Bottom == Bottom);
+      CHECK(Blob->Peak == Peak && RawMat[Blob->PeakIndex] == Peak);
+      CHECK(Blob->CentroidX == SumX * 256 / Blob->Area && Blob->CentroidY == SumY * 256 / Blob->Area);
+    }
+  }
+  //A checkerboard is the worst case of Neighbors4: every pixel is a blob
+  for(i = 0; i < FramePixels; i++) Mask[i] = ((i & 7) + (i >> 3)) & 1;
+  CHECK(BlobLabel(RawMat,Mask,0,Neighbors4,0,&List) == 0 && List.Count == MaxBlobs);
+  CHECK(BlobLabel(RawMat,Mask,0,Neighbors8,0,&List) == 0 && List.Count == 1);
+  CHECK(BlobLabel(RawMat,Mask,0,6,0,&List) == 1);
+}
+
+/*Walkers crossing one at a time or on rows far enough apart for their blobs not to touch:
+  one enter and one exit each, every crossing counted in its direction, never twice*/
+static void TestTrackAndCount(void)
+{
+  static const Walker Corridor[] =
+  {
+    {  0, 1,  96}, { 10, 5, -80}, { 45, 2, 128}, { 50, 6, -64}, { 95, 1, 100},
+    {100, 5, 110}, {150, 4, -96}, {160, 0, -120}, {185, 3, 72}, {220, 7, 80},
+    {226, 3, 80},  {270, 2, -90}, {275, 6, 90},  {330, 4, 140}, {335, 0, -140},
+    {380, 5, -70},
+  };
+  const uint8_t Walkers = sizeof(Corridor) / sizeof(Corridor[0]);
+  ObjectTracker Tracker;
+  LineCounter Door;
+  BlobList List;
+  int16_t RawMat[FramePixels];
+  uint16_t Frame,Enter = 0,Exit = 0,In = 0,Out = 0;
+  uint8_t e,w;
+
+  srand(2);
+  ObjectTrackerInit(&Tracker,512,2,2);
+  LineCounterInit(&Door,896,1792,896,0,128);
+  for(Frame = 0; Frame < 440; Frame++)
+  {
+    DrawCorridor(RawMat,Corridor,Walkers,Frame);
+    CHECK(BlobLabel(RawMat,NULL,26 * 4,Neighbors4,2,&List) == 0);
+    CHECK(ObjectTrackerUpdate(&Tracker,&List) == 0);
+    CHECK(Tracker.EventCount <= MaxTrackEvents);
+    for(e = 0; e < Tracker.EventCount; e++)
+    {
+      Enter += Tracker.Event[e].Type == TrackEnter;
+      Exit += Tracker.Event[e].Type == TrackExit;
+    }
+    LineCounterUpdate(&Door,&Tracker);
+  }
+  for(w = 0; w < Walkers; w++)
+  {
+    if(Corridor[w].Speed > 0) In++;
+    else Out++;
+  }
+  CHECK(Enter == Walkers && Exit == Walkers);
+  CHECK(Door.In == In && Door.Out == Out);
+}
+
+/*A person standing on the line and swaying inside the dead band is never counted,
+  one who then gets clear on one side and walks to the other is counted once*/
+static void TestLineDeadBand(void)
+{
+  ObjectTracker Tracker;
+  LineCounter Door;
+  BlobList List;
+  int16_t RawMat[FramePixels];
+  uint16_t Frame;
+  uint8_t i;
+
+  ObjectTrackerInit(&Tracker,512,1,2);
+  LineCounterInit(&Door,896,1792,896,0,128);
+  for(Frame = 0; Frame < 200; Frame++)
+  {
+    //Two columns warm: the centroid sways between 3.5 - 0.25 and 3.5 + 0.25 pixel
+    for(i = 0; i < FramePixels; i++) RawMat[i] = FLOOR;
+    for(i = 2; i < 5; i++)
+    {
+      RawMat[i * 8 + 3] = FLOOR + 40;
+      RawMat[i * 8 + 4] = FLOOR + 40;
+      if(Frame & 1) RawMat[i * 8 + 2] = FLOOR + 40;
+      else          RawMat[i * 8 + 5] = FLOOR + 40;
+    }
+    BlobLabel(RawMat,NULL,FLOOR + 20,Neighbors4,1,&List);
+    ObjectTrackerUpdate(&Tracker,&List);
+    LineCounterUpdate(&Door,&Tracker);
+  }
+  CHECK(Door.In == 0 && Door.Out == 0);
+  //Steps back clear to the left, then walks through to the right
+  for(Frame = 0; Frame < 6; Frame++)
+  {
+    for(i = 0; i < FramePixels; i++) RawMat[i] = FLOOR;
+    RawMat[3 * 8 + (Frame < 2 ? 2 : Frame)] = FLOOR + 40;
+    BlobLabel(RawMat,NULL,FLOOR + 20,Neighbors4,1,&List);
+    ObjectTrackerUpdate(&Tracker,&List);
+    LineCounterUpdate(&Door,&Tracker);
+  }
+  CHECK(Door.In == 1 && Door.Out == 0);
+}
+
+/*Random masks never overflow the event buffer nor give two objects one id*/
+static void TestTrackerBounds(void)
+{
+  ObjectTracker Tracker;
+  BlobList List;
+  int16_t RawMat[FramePixels] = {0};
+  uint8_t Mask[FramePixels],Seen[256];
+  uint32_t Frame;
+  uint8_t i,t;
+
+  srand(3);
+  ObjectTrackerInit(&Tracker,512,2,2);
+  for(Frame = 0; Frame < 50000; Frame++)
+  {
+    for(i = 0; i < FramePixels; i++) Mask[i] = rand() & 1;
+    BlobLabel(RawMat,Mask,0,Neighbors4,0,&List);
+    CHECK(ObjectTrackerUpdate(&Tracker,&List) == 0);
+    CHECK(Tracker.EventCount <= MaxTrackEvents);
+    memset(Seen,0,sizeof(Seen));
+    for(t = 0; t < MaxTracks; t++)
+    {
+      if(Tracker.Track[t].Id == 0) continue;
+      CHECK(Seen[Tracker.Track[t].Id] == 0);
+      Seen[Tracker.Track[t].Id] = 1;
+    }
+  }
+}
+
+/*Background model: quiet scene gives no foreground, a person is found, a heater switched on
+  is absorbed once MaxFreeze runs out*/
+static void TestBackgroundModel(void)
+{
+  BackgroundModel Model;
+  int16_t RawMat[FramePixels];
+  uint8_t Mask[FramePixels];
+  uint16_t Frame,Absorbed = 0;
+  uint32_t False = 0,Found = 0,Person = 0;
+  uint8_t i,x,y,InPerson,InHeater,Any;
+
+  srand(4);
+  BackgroundModelInit(&Model,5,12,6,2);
+  for(Frame = 0; Frame < 3000; Frame++)
+  {
+    for(i = 0; i < FramePixels; i++)
+    {
+      x = i & 7;
+      y = i >> 3;
+      InPerson = Frame > 300 && Frame < 1500 && Frame % 200 < 60 && abs(x - (Frame % 200) * 8 / 60) <= 1 && abs(y - 3) <= 1;
+      InHeater = Frame >= 1500 && x >= 6 && y <= 1;
+      RawMat[i] = FLOOR + x + y / 2 + Noise() + (InPerson ? 40 : 0) + (InHeater ? 80 : 0);
+    }
+    BackgroundModelUpdate(&Model,RawMat,Mask);
+    if(Frame < 100) continue;
+    Any = 0;
+    for(i = 0; i < FramePixels; i++)
+    {
+      x = i & 7;
+      y = i >> 3;
+      InPerson = Frame > 300 && Frame < 1500 && Frame % 200 < 60 && abs(x - (Frame % 200) * 8 / 60) <= 1 && abs(y - 3) <= 1;
+      InHeater = Frame >= 1500 && x >= 6 && y <= 1;
+      if(InPerson) { Person++; Found += Mask[i]; }
+      else if(InHeater) Any |= Mask[i];
+      else False += Mask[i];
+    }
+    if(Frame >= 1500 && !Any && Absorbed == 0) Absorbed = Frame - 1500;
+  }
+  CHECK(False == 0);
+  CHECK(Found == Person);
+  CHECK(Absorbed >= Model.MaxFreeze && Absorbed < Model.MaxFreeze + 100);
+}
+
+/*Checking only the pixels flagged by the loosest band gives the alarms of a full check*/
+static void TestThresholdMap(void)
+{
+  ThresholdMap Filtered,Full;
+  int16_t RawMat[FramePixels],Base[FramePixels],High,Low;
+  uint8_t Table[8];
+  uint16_t Run,Frame;
+  uint32_t Skipped = 0;
+  uint8_t i,Any;
+
+  srand(5);
+  for(Run = 0; Run < 500; Run++)
+  {
+    ThresholdMapInit(&Filtered,120 + rand() % 40,ThresholdLowOff,rand() % 8);
+    for(i = 0; i < FramePixels; i++)
+    {
+      if(rand() % 3 == 0) Filtered.High[i] = ThresholdHighOff;
+      else Filtered.High[i] = 110 + rand() % 60;
+      if(rand() % 4 == 0) Filtered.Low[i] = 20 + rand() % 20;
+      Base[i] = 60 + rand() % 25;
+    }
+    Full = Filtered;
+    ThresholdMapBand(&Filtered,&High,&Low);
+    for(Frame = 0; Frame < 200; Frame++)
+    {
+      Any = 0;
+      memset(Table,0,sizeof(Table));
+      for(i = 0; i < FramePixels; i++)
+      {
+        Base[i] += rand() % 7 - 3;
+        if(rand() % 2000 == 0) Base[i] += 60;
+        if(Base[i] < 10) Base[i] = 10;
+        if(Base[i] > 180) Base[i] = 80;
+        RawMat[i] = Base[i];
+        if(RawMat[i] > High || RawMat[i] < Low)
+        {
+          Table[i >> 3] |= 1 << (i & 7);
+          Any = 1;
+        }
+      }
+      ThresholdMapEvaluate(&Full,RawMat,NULL);
+      if(Any) ThresholdMapEvaluate(&Filtered,RawMat,Table);
+      else
+      {
+        //What readPixelAlarms() does while the INT pin is idle
+        Filtered.Count = 0;
+        memset(Filtered.Alarm,0,sizeof(Filtered.Alarm));
+        Skipped++;
+      }
+      CHECK(Filtered.Count == Full.Count && memcmp(Filtered.Alarm,Full.Alarm,sizeof(Full.Alarm)) == 0);
+    }
+  }
+  CHECK(Skipped > 0);
+}
+
+/*Rate of rise over about 10s: a fast ramp alarms and clears after it, a slow
+  drift and the noise do not*/
+static void CheckRiseRamp(uint8_t SamplePeriod,uint8_t Window,int16_t RiseOn,int16_t RiseOff)
+{
+  RiseDetector Detector;
+  int16_t History[RiseMaxWindow * FramePixels];
+  int16_t RawMat[FramePixels];
+  int16_t RiseAt1400 = 0,Expected;
+  uint16_t Frame,Raised = 0,Cleared = 0;
+  uint32_t Others = 0;
+  uint8_t i,On;
+
+  srand(6);
+  RiseDetectorInit(&Detector,History,SamplePeriod,Window,RiseOn,RiseOff);
+  for(Frame = 0; Frame < 3000; Frame++)
+  {
+    for(i = 0; i < FramePixels; i++) RawMat[i] = 100 + Noise();
+    RawMat[9] += (Frame < 1000 ? Frame : 1000) * 8 / 100;                  //2℃ per 10s, then steady
+    if(Frame >= 1000) RawMat[42] += (Frame < 1600 ? Frame - 1000 : 600) * 32 / 100;   //8℃ per 10s for 60s
+    RiseDetectorUpdate(&Detector,RawMat);
+    for(i = 0; i < FramePixels; i++)
+    {
+      if(i != 42) Others += (Detector.Alarm[i >> 3] >> (i & 7)) & 1;
+    }
+    On = (Detector.Alarm[42 >> 3] >> (42 & 7)) & 1;
+    if(On && Raised == 0) Raised = Frame;
+    if(Raised != 0 && !On && Cleared == 0) Cleared = Frame;
+    if(Frame == 1400) RiseAt1400 = Detector.MaxRise;
+  }
+  CHECK(Others == 0);
+  CHECK(Raised > 1000 && Raised < 1000 + 100);
+  CHECK(Cleared > 1600 && Cleared < 1600 + 100);
+  Expected = 32 * (Window - 1) * SamplePeriod / 100;   //8℃ per 10s over the frames of the window
+  CHECK(RiseAt1400 >= Expected - 2 && RiseAt1400 <= Expected + 2);
+}
+
+/*FPS_10: 8 samples over 9.8s, then the 512-byte history of a small board, 4
+  samples over 4.8s, both alarming at 5℃ per 10s*/
+static void TestRiseRamp(void)
+{
+  CheckRiseRamp(14,8,20,12);
+  CheckRiseRamp(16,4,10,6);
+}
+
+int main(void)
+{
+  RUN(TestBlobLabel);
+  RUN(TestTrackAndCount);
+  RUN(TestLineDeadBand);
+  RUN(TestTrackerBounds);
+  RUN(TestBackgroundModel);
+  RUN(TestThresholdMap);
+  RUN(TestRiseRamp);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,116 @@
+/*****************************************************************
+File:             test_hotspot.cpp
+Author:           BESTMODULES
+Description:      Host tests of the BMS26M833 frame readers on a register file (stub/Wire.h):
+                  decoding of the 12-bit pixels and sub-pixel accuracy of readPixelsAndHotspot().
+History：
+V1.0.1   -- initial version；2026-10-19
+******************************************************************/
+#include <stdlib.h>
+#include "BMS26M833.h"
+#include "check.h"
+
+TwoWire Wire;
+
+/*Write one pixel register pair (unit:0.25℃)*/
+static void SetPixel(uint8_t Index,int16_t Raw)
+{
+  uint16_t Reg = (uint16_t)Raw & 0x0FFF;
+
+  Wire.Regs[REG_T01L + 2 * Index] = Reg & 0xFF;
+  Wire.Regs[REG_T01L + 2 * Index + 1] = Reg >> 8;
+}
+
+/*Gaussian spot of peak Amplitude above Base at (Cx,Cy), in pixels*/
+static double DrawSpot(double Cx,double Cy,double Sigma,double Amplitude,double Base)
+{
+  for(uint8_t i = 0; i < 64; i++)
+  {
+    double dx = (i & 7) - Cx,dy = (i >> 3) - Cy;
+    SetPixel(i,(int16_t)lround(4 * (Base + Amplitude * exp(-(dx * dx + dy * dy) / (2 * Sigma * Sigma)))));
+  }
+  return Base + Amplitude;
+}
+
+/*All readers decode the same frame, negative temperatures included*/
+static void TestDecode(void)
+{
+  BMS26M833 Sensor(8,&Wire);
+  float Temp[64],TempMax[64],Max,Min,MaxF,MinF;
+  int16_t Raw[64],RawMax,RawMin;
+
+  for(uint8_t i = 0; i < 64; i++) SetPixel(i,(int16_t)(i * 61 % 640) - 160);   //-40℃ ~ +119.75℃
+  Sensor.readPixels(Temp);
+  Sensor.readPixelsAndMaximum(TempMax,MaxF,MinF);
+  Sensor.readRawPixelsAndMaximum(Raw,RawMax,RawMin);
+  Max = -1000;
+  Min = 1000;
+  for(uint8_t i = 0; i < 64; i++)
+  {
+    CHECK(Raw[i] == (int16_t)(i * 61 % 640) - 160);
+    CHECK(Temp[i] == Raw[i] * 0.25f && TempMax[i] == Temp[i]);
+    if(Temp[i] > Max) Max = Temp[i];
+    if(Temp[i] < Min) Min = Temp[i];
+  }
+  CHECK(RawMax * 0.25f == Max && RawMin * 0.25f == Min);
+  CHECK(MaxF == Max);
+}
+
+/*Random Gaussian spots inside the frame: both estimates are well within a pixel,
+  the parabola peak is close to the true peak*/
+static void TestHotspotAccuracy(void)
+{
+  BMS26M833 Sensor(8,&Wire);
+  BMS26M833Hotspot Hotspot;
+  float Temp[64],Max,Min;
+  double Peak,Cx,Cy,Error,SumVertex = 0,SumCentroid = 0,SumPeak = 0,MaxVertex = 0;
+  const int Spots = 5000;
+
+  srand(1);
+  for(int k = 0; k < Spots; k++)
+  {
+    Cx = 1 + 6.0 * rand() / RAND_MAX;
+    Cy = 1 + 6.0 * rand() / RAND_MAX;
+    Peak = DrawSpot(Cx,Cy,0.7 + 0.8 * rand() / RAND_MAX,10 + 40.0 * rand() / RAND_MAX,-5 + 30.0 * rand() / RAND_MAX);
+    Sensor.readPixelsAndHotspot(Temp,Max,Min,Hotspot);
+    CHECK(Temp[Hotspot.index] == Max);
+    Error = hypot(Hotspot.peakX / 256.0 - Cx,Hotspot.peakY / 256.0 - Cy);
+    SumVertex += Error;
+    if(Error > MaxVertex) MaxVertex = Error;
+    SumCentroid += hypot(Hotspot.centroidX / 256.0 - Cx,Hotspot.centroidY / 256.0 - Cy);
+    SumPeak += fabs(Hotspot.peakValue / 64.0 - Peak);
+  }
+  printf("  vertex %.3f px (max %.3f), centroid %.3f px, peak %.3f C\n",
+         SumVertex / Spots,MaxVertex,SumCentroid / Spots,SumPeak / Spots);
+  CHECK(SumVertex / Spots < 0.15);
+  CHECK(MaxVertex < 0.71);           //Within half a pixel on each axis
+  CHECK(SumCentroid / Spots < 0.15);
+  CHECK(SumPeak / Spots < 1.5);
+}
+
+/*Steepest spot of the measuring range, 80℃ in a -20℃ scene: 2 * (L - R)^2 is
+  beyond the 16-bit int of AVR*/
+static void TestHotspotRange(void)
+{
+  BMS26M833 Sensor(8,&Wire);
+  BMS26M833Hotspot Hotspot;
+  float Temp[64],Max,Min;
+
+  for(uint8_t i = 0; i < 64; i++) SetPixel(i,-80);
+  SetPixel(3 * 8 + 4,320);
+  SetPixel(3 * 8 + 3,300);           //Left and upper neighbours far above the right and lower ones
+  SetPixel(2 * 8 + 4,300);
+  Sensor.readPixelsAndHotspot(Temp,Max,Min,Hotspot);
+  CHECK(Hotspot.index == 3 * 8 + 4);
+  CHECK(Hotspot.peakX == 4 * 256 - 128 * 380 / 420);
+  CHECK(Hotspot.peakY == 3 * 256 - 128 * 380 / 420);
+  CHECK(Hotspot.peakValue == 320 * 16 + 2 * (2 * 380L * 380 / 420));
+}
+
+int main(void)
+{
+  RUN(TestDecode);
+  RUN(TestHotspotAccuracy);
+  RUN(TestHotspotRange);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,780 @@
+/*****************************************************************
+File:             test_imaging.c
+Author:           BESTMODULES
+Description:      Host tests of the imaging pipeline of the DisplayThermalImagingOnTheTFT
+                  example on synthetic 8*8 scenes. "./test_imaging bench" measures the 
+                  images per millisecond at every SIMD level.
+History：
+V1.0.1   -- initial version；2026-10-19
+******************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "InfraredThermalImaging.h"
+#include "check.h"
+
+#define OutSize  56              //8*8 -> 56*56 as in the example
+#define TileSize 16              //Tiles of the tiled tests, the last ones are cut short
+#define BatchFrames (2 * BatchGroup + 3)  //Sensors of the batch test, the last group is cut short
+
+static unsigned int Palette[MaxGrayscale];
+
+/*Palette with a different colour for every gray level*/
+static void MakePalette(void)
+{
+  uint16_t i;
+
+  for(i = 0; i < MaxGrayscale; i++) Palette[i] = (unsigned int)((i >> 3) << 11 | i << 3 | (255 - i) >> 3);
+}
+
+/*Room at Ambient with a warm spot 2 pixels across at (Cx,Cy), in pixels, and noise of
+  a quarter degree; the range of the frame in *Max, *Min*/
+static void DrawScene(float *InMat,float Ambient,float Cx,float Cy,float Peak,float *Max,float *Min)
+{
+  uint8_t i;
+  float dx,dy;
+
+  *Max = -1000;
+  *Min = 1000;
+  for(i = 0; i < 64; i++)
+  {
+    dx = (i & 7) - Cx;
+    dy = (i >> 3) - Cy;
+    InMat[i] = floorf(4 * (Ambient + Peak * expf(-(dx * dx + dy * dy) / 2)) + rand() % 3 - 1) / 4;
+    if(InMat[i] > *Max) *Max = InMat[i];
+    if(InMat[i] < *Min) *Min = InMat[i];
+  }
+}
+
+/*Tiles of one prepared frame join into the image of InfraredThermalImagingFused(), 
+  with the gain, tracker and overlay advancing once per frame; an engine of another
+  geometry is refused*/
+static void CheckTiles(uint8_t PixelFormat)
+{
+  InterpEngine Engine;
+  OtusTracker Tracker[2];
+  AutoGain Gain[2];
+  IsothermOverlay Overlay[2];
+  ThermalImagingConfig Full,Tiled;
+  float InMat[64];
+  uint16_t FullMat[OutSize * OutSize],TileMat[TileSize * TileSize],Image[OutSize * OutSize];
+  uint8_t GrayMat[MaxInPixels];
+  uint16_t Frame,x,y,w,h,r;
+  uint8_t k,Size = PixelFormat == PixelRGB565 ? 2 : 1;
+
+  srand(2);
+  CHECK(InterpInit(&Engine,KernelBilinear,NULL,8,8,OutSize,OutSize) == 0);
+  memset(&Full,0,sizeof(Full));
+  Full.InMat = InMat;
+  Full.InWidth = Full.InHeight = 8;
+  Full.OutWidth = Full.OutHeight = OutSize;
+  Full.Background = 0;
+  Full.TempDiff = 2;
+  Full.PixelFormat = PixelFormat;
+  Full.Palette = Palette;
+  Full.Engine = &Engine;
+  Tiled = Full;
+  for(k = 0; k < 2; k++)
+  {
+    OtusTrackerInit(&Tracker[k]);
+    AutoGainInit(&Gain[k],AgcSmoothRange | AgcEqualize,3,16);
+    memset(&Overlay[k],0,sizeof(IsothermOverlay));
+    Overlay[k].Count = 1;
+    Overlay[k].Band[0].TempLow = 30;
+    Overlay[k].Band[0].TempHigh = 32;
+    Overlay[k].Band[0].Color = 0xFFFF;
+    Overlay[k].Band[0].Gray = 255;
+  }
+  Full.Tracker = &Tracker[0];  Full.Gain = &Gain[0];  Full.Overlay = &Overlay[0];  Full.OutMat = FullMat;
+  Tiled.Tracker = &Tracker[1]; Tiled.Gain = &Gain[1]; Tiled.Overlay = &Overlay[1]; Tiled.OutMat = TileMat;
+
+  for(Frame = 0; Frame < 40; Frame++)
+  {
+    DrawScene(InMat,22 + Frame * 0.1f,1 + Frame * 0.15f,3.5f,12,&Full.TempMax,&Full.TempMin);
+    Tiled.TempMax = Full.TempMax;
+    Tiled.TempMin = Full.TempMin;
+    CHECK(InfraredThermalImagingFused(&Full) == 0);
+    CHECK(InfraredThermalImagingPrepare(&Tiled,GrayMat) == 0);
+    for(y = 0; y < OutSize; y += TileSize)
+    {
+      for(x = 0; x < OutSize; x += TileSize)
+      {
+        w = OutSize - x < TileSize ? OutSize - x : TileSize;
+        h = OutSize - y < TileSize ? OutSize - y : TileSize;
+        CHECK(InfraredThermalImagingTile(&Tiled,GrayMat,x,y,w,h) == 0);
+        for(r = 0; r < h; r++)
+        {
+          memcpy((uint8_t *)Image + ((uint32_t)(y + r) * OutSize + x) * Size,(uint8_t *)TileMat + (uint32_t)r * w * Size,w * Size);
+        }
+      }
+    }
+    CHECK(memcmp(Image,FullMat,(uint32_t)OutSize * OutSize * Size) == 0);
+  }
+  CHECK(InfraredThermalImagingTile(&Tiled,GrayMat,OutSize - 8,0,TileSize,8) == 1);
+
+  //An engine prepared for a larger input would read past GrayMat
+  CHECK(InterpInit(&Engine,KernelBilinear,NULL,8,40,OutSize,OutSize) == 0);
+  CHECK(InfraredThermalImagingTile(&Tiled,GrayMat,0,0,TileSize,TileSize) == 1);
+}
+
+static void TestTiles(void)
+{
+  MakePalette();
+  CheckTiles(PixelGray8);
+  CheckTiles(PixelRGB565);
+}
+
+/*A hot object sits in the view while the sensor sways by fractions of a pixel, then
+  the sensor stops and the object slowly cools down: 50 frames after the sway, no cell
+  of the grid is warmer than the scene, including the cells no pixel falls into any more*/
+static void TestSuperResFade(void)
+{
+  SuperResolution SuperRes;
+  float InMat[64],OutMat[MaxSuperResPixels],Max,Warmest = 0,Sx,Sy,dx,dy,Object;
+  uint16_t Frame,Cell,Restarts = 0;
+  uint8_t i;
+
+  CHECK(SuperResInit(&SuperRes,8,8,2,3) == 0);
+  for(Frame = 0; Frame <= 250; Frame++)
+  {
+    Sx = 0.3f * sinf((Frame < 100 ? Frame : 99) * 0.21f);
+    Sy = 0.3f * cosf((Frame < 100 ? Frame : 99) * 0.13f);
+    Object = Frame < 100 ? 10 : 10 - (Frame - 100) * 0.05f;
+    Warmest = 0;
+    for(i = 0; i < 64; i++)
+    {
+      //Texture for the registration and the object at (4,4)
+      dx = (i & 7) + Sx - 4;
+      dy = (i >> 3) + Sy - 4;
+      InMat[i] = 22 + 1.5f * sinf(0.9f * ((i & 7) + Sx)) + 1.5f * cosf(0.7f * ((i >> 3) + Sy)) + Object * expf(-(dx * dx + dy * dy));
+      InMat[i] = floorf(InMat[i] * 4 + 0.5f) / 4;
+      if(InMat[i] > Warmest) Warmest = InMat[i];
+    }
+    if(SuperResUpdate(&SuperRes,InMat,OutMat) != 0 && Frame >= 100) Restarts++;
+    if(Frame == 99)
+    {
+      Max = 0;
+      for(Cell = 0; Cell < 256; Cell++) if(OutMat[Cell] > Max) Max = OutMat[Cell];
+      CHECK(Max > 28);
+    }
+  }
+  Max = 0;
+  for(Cell = 0; Cell < 256; Cell++) if(OutMat[Cell] > Max) Max = OutMat[Cell];
+  printf("  peak %.2f C, warmest pixel %.2f C\n",Max,Warmest);
+  CHECK(Restarts == 0);                 //The grid was never cleared, the cells had to fade
+  CHECK(Max <= Warmest + 0.25f);
+}
+
+/*Only the bicubic kernel needs a weight table, one table serves several engines and a
+  flat image stays flat*/
+static void TestBicubicWeights(void)
+{
+  InterpEngine Engine[2];
+  InterpWeights Weights;
+  uint8_t InMat[64],OutMat[OutSize * OutSize];
+  uint16_t i;
+  uint8_t k;
+
+  CHECK(InterpInit(&Engine[0],KernelBicubic,NULL,8,8,OutSize,OutSize) == 1);
+  CHECK(InterpInit(&Engine[0],KernelEdge,NULL,8,8,OutSize,OutSize) == 0 && Engine[0].Weights == NULL);
+  CHECK(InterpInit(&Engine[0],KernelBicubic,&Weights,8,8,OutSize,OutSize) == 0);
+  CHECK(InterpInit(&Engine[1],KernelBicubic,&Weights,8,8,OutSize / 2,OutSize / 2) == 0);
+  for(i = 0; i < InterpPhases; i++)
+  {
+    CHECK(Weights.Weight[i][0] + Weights.Weight[i][1] + Weights.Weight[i][2] + Weights.Weight[i][3] == 2048);
+  }
+  memset(InMat,77,sizeof(InMat));
+  for(k = 0; k < 2; k++)
+  {
+    CHECK(InterpRun(&Engine[k],InMat,OutMat) == 0);
+    for(i = 0; i < Engine[k].OutWidth * Engine[k].OutHeight; i++) CHECK(OutMat[i] == 77);
+  }
+}
+
+/*The incremental Otus threshold equals a full recount on every frame of a drifting
+  scene, with still frames, jumps and a change of geometry*/
+static void TestOtusTracker(void)
+{
+  OtusTracker Tracker;
+  uint8_t GrayMat[MaxInPixels];
+  uint16_t Frame,i,Pixels = 64;
+  uint8_t Width = 8,Height = 8,Changes;
+
+  srand(7);
+  OtusTrackerInit(&Tracker);
+  for(i = 0; i < MaxInPixels; i++) GrayMat[i] = rand() % 2 ? 40 + rand() % 30 : 160 + rand() % 60;
+  for(Frame = 0; Frame < 5000; Frame++)
+  {
+    if(Frame == 2500)
+    {
+      Width = Height = 16;                   //Super-resolution grid
+      Pixels = 256;
+    }
+    Changes = Frame % 7 == 0 ? 0 : (Frame % 97 == 0 ? 200 : rand() % 6);
+    while(Changes-- > 0)
+    {
+      i = rand() % Pixels;
+      GrayMat[i] = Frame % 97 == 0 ? rand() : GrayMat[i] + rand() % 9 - 4;
+    }
+    CHECK(OtusTrackerUpdate(&Tracker,GrayMat,Width,Height) == Otus(GrayMat,Width,Height));
+  }
+}
+
+/*Reference filter that reads a separate copy of the frame, 4 neighbours*/
+static void FilterCopy(uint8_t *SrcMat,uint8_t *DstMat,int Width,int Height,uint8_t Threshold,uint8_t Background)
+{
+  static const int Dx[4] = {0,0,-1,1},Dy[4] = {-1,1,0,0};
+  int row,col,k,x,y,Keep;
+
+  for(row = 0; row < Height; row++)
+  {
+    for(col = 0; col < Width; col++)
+    {
+      Keep = Background == 0 || SrcMat[row * Width + col] >= Threshold;
+      for(k = 0; k < 4; k++)
+      {
+        x = col + Dx[k];
+        y = row + Dy[k];
+        if(x < 0 || y < 0 || x >= Width || y >= Height) continue;
+        if(SrcMat[y * Width + x] >= Threshold && SrcMat[y * Width + x] - SrcMat[row * Width + col] >= Background) Keep = 1;
+      }
+      DstMat[row * Width + col] = Keep ? SrcMat[row * Width + col] : 0;
+    }
+  }
+}
+
+/*Synthetic scenes, also larger than MaxInPixels: the in-place filter matches the
+  copy-based reference and BackgroundSuppress(), a hot target keeps its pixels and
+  its bright rim while the flat background is cleared*/
+static void TestBackgroundFilter(void)
+{
+  static const uint16_t Sizes[4][2] = {{8,8},{16,16},{32,24},{5,40}};
+  static uint8_t InMat[32 * 40],Expect[32 * 40],OutMat[32 * 40];
+  uint16_t s,i,Width,Height,Total;
+  uint8_t Threshold,Background;
+  int Run;
+
+  srand(11);
+  for(s = 0; s < 4; s++)
+  {
+    Width = Sizes[s][0];
+    Height = Sizes[s][1];
+    Total = Width * Height;
+    for(Run = 0; Run < 50; Run++)
+    {
+      for(i = 0; i < Total; i++) InMat[i] = rand() % 4 ? 30 + rand() % 40 : 120 + rand() % 120;
+      Threshold = 60 + rand() % 80;
+      Background = Run % 10 == 0 ? 0 : 5 + rand() % 40;
+      FilterCopy(InMat,Expect,Width,Height,Threshold,Background);
+      CHECK(BackgroundSuppress(InMat,OutMat,Width,Height,Threshold,Background,Neighbors4) == 0);
+      CHECK(memcmp(OutMat,Expect,Total) == 0);
+      CHECK(BackgroundFiltering(InMat,Width,Height,Threshold,Background) == 0);
+      CHECK(memcmp(InMat,Expect,Total) == 0);
+    }
+  }
+
+  //24*20 scene: 40 background, 3*3 target at 200 with a 100 rim on its left side, threshold 120
+  Width = 24;
+  Height = 20;
+  memset(InMat,40,Width * Height);
+  for(i = 0; i < 9; i++) InMat[(8 + i / 3) * Width + 12 + i % 3] = 200;
+  for(i = 0; i < 3; i++) InMat[(8 + i) * Width + 11] = 100;
+  InMat[2 * Width + 3] = 55;                 //Noise below the threshold
+  CHECK(BackgroundFiltering(InMat,Width,Height,120,20) == 0);
+  for(i = 0; i < Width * Height; i++)
+  {
+    if(i % Width >= 11 && i % Width <= 14 && i / Width >= 8 && i / Width <= 10) CHECK(InMat[i] == (i % Width == 11 ? 100 : 200));
+    else if((i % Width == 15 && i / Width >= 8 && i / Width <= 10) || (i % Width >= 12 && i % Width <= 14 && (i / Width == 7 || i / Width == 11))) CHECK(InMat[i] == 40);
+    else CHECK(InMat[i] == 0);
+  }
+}
+
+static void CountRows(uint16_t Row,void *RowMat,uint16_t Width,void *Arg)
+{
+  (void)Row;
+  (void)RowMat;
+  (void)Width;
+  (*(uint16_t *)Arg)++;
+}
+
+/*RGB565 without a palette is refused by every entry point before anything is written*/
+static void TestMissingPalette(void)
+{
+  InterpEngine Engine;
+  OtusTracker Tracker;
+  ThermalImagingConfig Config;
+  float InMat[64];
+  uint16_t OutMat[OutSize * OutSize],Rows = 0;
+  uint8_t GrayMat[MaxInPixels] = {0};
+
+  srand(4);
+  CHECK(InterpInit(&Engine,KernelBilinear,NULL,8,8,OutSize,OutSize) == 0);
+  OtusTrackerInit(&Tracker);
+  memset(&Config,0,sizeof(Config));
+  DrawScene(InMat,22,4,4,10,&Config.TempMax,&Config.TempMin);
+  Config.InMat = InMat;
+  Config.OutMat = OutMat;
+  Config.InWidth = Config.InHeight = 8;
+  Config.OutWidth = Config.OutHeight = OutSize;
+  Config.TempDiff = 2;
+  Config.PixelFormat = PixelRGB565;
+  Config.Engine = &Engine;
+  Config.Tracker = &Tracker;
+  CHECK(InfraredThermalImaging(&Config) == 1);
+  CHECK(InfraredThermalImagingFused(&Config) == 1);
+  CHECK(InfraredThermalImagingStream(&Config,CountRows,&Rows) == 1 && Rows == 0);
+  CHECK(InfraredThermalImagingPrepare(&Config,GrayMat) == 1);
+  CHECK(InfraredThermalImagingTile(&Config,GrayMat,0,0,8,8) == 1);
+  CHECK(Tracker.TotalPixels == 0);
+  CHECK(InterpRunTileColor(&Engine,GrayMat,OutMat,NULL,0,0,8,8) == 1);
+  CHECK(PaletteMap(GrayMat,OutMat,NULL,64) == 1);
+}
+
+/*BilinearFast() with the tables of BilinearInit() gives the bytes of Bilinear() on random
+  geometries up to MaxOutSize and random data*/
+static void TestBilinearTable(void)
+{
+  static BilinearTable Table;
+  static uint8_t InMat[16 * 16],Expect[MaxOutSize * MaxOutSize],OutMat[MaxOutSize * MaxOutSize];
+  uint16_t Run,i,InWidth,InHeight,OutWidth,OutHeight;
+
+  srand(12);
+  CHECK(BilinearInit(&Table,8,8,MaxOutSize + 1,8) == 1);
+  for(Run = 0; Run < 1000; Run++)
+  {
+    InWidth = 2 + rand() % 15;
+    InHeight = 2 + rand() % 15;
+    OutWidth = 1 + rand() % MaxOutSize;
+    OutHeight = 1 + rand() % MaxOutSize;
+    for(i = 0; i < InWidth * InHeight; i++) InMat[i] = rand();
+    CHECK(BilinearInit(&Table,InWidth,InHeight,OutWidth,OutHeight) == 0);
+    Bilinear(InMat,Expect,InWidth,InHeight,OutWidth,OutHeight);
+    BilinearFast(&Table,InMat,OutMat);
+    CHECK(memcmp(OutMat,Expect,OutWidth * OutHeight) == 0);
+  }
+}
+
+/*InfraredThermalImagingFused() gives the bytes of InfraredThermalImaging() on random frames
+  of the 0.25 degC sensor grid, negative ones included, through the engine of every kernel,
+  the bilinear tables and Bilinear(); frames with equal Max and Min or a difference of
+  exactly TempDiff leave the output untouched in both*/
+static void TestFusedStaged(void)
+{
+  static const uint8_t Kernels[3] = {KernelBilinear,KernelBicubic,KernelEdge};
+  static BilinearTable Table;
+  static uint16_t Staged[OutSize * OutSize],Fused[OutSize * OutSize];
+  InterpEngine Engine;
+  InterpWeights Weights;
+  ThermalImagingConfig Config;
+  float InMat[64];
+  uint16_t Frame,Range,Imaged = 0;
+  uint8_t i,Path,Size;
+
+  MakePalette();
+  srand(13);
+  CHECK(BilinearInit(&Table,8,8,OutSize,OutSize) == 0);
+  memset(&Config,0,sizeof(Config));
+  Config.InMat = InMat;
+  Config.InWidth = Config.InHeight = 8;
+  Config.OutWidth = Config.OutHeight = OutSize;
+  Config.Palette = Palette;
+  for(Frame = 0; Frame < 3000; Frame++)
+  {
+    Config.TempDiff = rand() % 6;
+    switch(Frame % 10)
+    {
+      case 0:  Range = 0;                        break;   //Max == Min
+      case 1:  Range = 4 * Config.TempDiff;      break;   //Exactly TempDiff
+      case 2:  Range = 4 * Config.TempDiff + 1;  break;   //One step above
+      default: Range = rand() % 400;             break;
+    }
+    Config.TempMin = (rand() % 400 - 100) * 0.25f;
+    Config.TempMax = Config.TempMin + Range * 0.25f;
+    for(i = 0; i < 64; i++) InMat[i] = Config.TempMin + (rand() % (Range + 1)) * 0.25f;
+    InMat[rand() % 64] = Config.TempMin;
+    InMat[rand() % 64] = Config.TempMax;
+    Config.Background = rand() % 2 ? 20 : 0;
+
+    //0 ~ 2: engine kernels (both formats), 3: bilinear tables, 4: Bilinear()
+    Path = rand() % 5;
+    Config.Engine = NULL;
+    Config.Table = NULL;
+    Config.PixelFormat = PixelGray8;
+    if(Path < 3)
+    {
+      CHECK(InterpInit(&Engine,Kernels[Path],Path == 1 ? &Weights : NULL,8,8,OutSize,OutSize) == 0);
+      Config.Engine = &Engine;
+      if(rand() % 2) Config.PixelFormat = PixelRGB565;
+    }
+    else if(Path == 3) Config.Table = &Table;
+    Size = Config.PixelFormat == PixelRGB565 ? 2 : 1;
+
+    memset(Staged,0xA5,sizeof(Staged));
+    memset(Fused,0xA5,sizeof(Fused));
+    Config.OutMat = Staged;
+    CHECK(InfraredThermalImaging(&Config) == 0);
+    Config.OutMat = Fused;
+    CHECK(InfraredThermalImagingFused(&Config) == 0);
+    CHECK(memcmp(Staged,Fused,(uint32_t)OutSize * OutSize * Size) == 0);
+    if(Range * 0.25f <= Config.TempDiff) CHECK(Fused[0] == 0xA5A5 && Fused[OutSize * OutSize / 2 - 1] == 0xA5A5);
+    else Imaged++;
+  }
+  CHECK(Imaged > 2000);
+}
+
+/*TransformGrayFixed() on random raw frames, negative temperatures included, against
+  TransformGray() on the same temperatures: equal for ranges below 64 degC (256 raw steps),
+  at most 1 level higher above that; 0 at Min and 255 at Max, also for a one-level span*/
+static void TestGrayFixed(void)
+{
+  int16_t RawMat[64],Max,Min;
+  float Temp[64];
+  uint8_t Fixed[64],Float[64];
+  uint16_t Frame,Range;
+  uint8_t i;
+  uint32_t Higher = 0;
+
+  srand(14);
+  for(Frame = 0; Frame < 20000; Frame++)
+  {
+    switch(Frame % 8)
+    {
+      case 0:  Range = 1;                break;   //One-level span
+      case 1:  Range = 1 + rand() % 255; break;   //Below 64 degC
+      default: Range = rand() % 1200;    break;
+    }
+    Min = rand() % 1200 - 400;             //-100 ~ 200 degC
+    Max = Min + Range;
+    for(i = 0; i < 64; i++) RawMat[i] = Min + (Range == 0 ? 0 : rand() % (Range + 1));
+    RawMat[rand() % 64] = Min;
+    RawMat[rand() % 64] = Max;
+    for(i = 0; i < 64; i++) Temp[i] = RawMat[i] * 0.25f;
+    TransformGrayFixed(RawMat,Fixed,8,8,Max,Min);
+    TransformGray(Temp,Float,8,8,Max * 0.25f,Min * 0.25f);
+    for(i = 0; i < 64; i++)
+    {
+      if(Range < 256) CHECK(Fixed[i] == Float[i]);
+      else CHECK(Fixed[i] == Float[i] || Fixed[i] == Float[i] + 1);
+      Higher += Fixed[i] != Float[i];
+      if(RawMat[i] == Min) CHECK(Fixed[i] == 0);
+      else if(RawMat[i] == Max) CHECK(Fixed[i] == 255);
+    }
+  }
+  CHECK(Higher < 20000 * 64 / 1000);     //Rare even above 64 degC
+}
+
+/*Rows emitted by InfraredThermalImagingStream(), copied into a full image*/
+typedef struct
+{
+  uint8_t *Image;
+  uint8_t Size;                  //Bytes per pixel
+  uint16_t Rows;
+}StreamImage;
+
+static void CopyRow(uint16_t Row,void *RowMat,uint16_t Width,void *Arg)
+{
+  StreamImage *Stream = (StreamImage *)Arg;
+
+  memcpy(Stream -> Image + (uint32_t)Row * Width * Stream -> Size,RowMat,(uint32_t)Width * Stream -> Size);
+  Stream -> Rows++;
+}
+
+/*The streamed rows join into the image of InfraredThermalImagingFused() on random scenes,
+  kernels and formats; an engine prepared for another geometry is refused*/
+static void TestStream(void)
+{
+  static const uint8_t Kernels[3] = {KernelBilinear,KernelBicubic,KernelEdge};
+  InterpEngine Engine,Other;
+  InterpWeights Weights;
+  ThermalImagingConfig Config;
+  StreamImage Stream;
+  float InMat[64];
+  uint16_t FullMat[OutSize * OutSize],Image[OutSize * OutSize],RowMat[OutSize];
+  uint16_t Frame;
+  uint8_t Kernel;
+
+  MakePalette();
+  srand(8);
+  memset(&Config,0,sizeof(Config));
+  Config.InMat = InMat;
+  Config.InWidth = Config.InHeight = 8;
+  Config.OutWidth = Config.OutHeight = OutSize;
+  Config.TempDiff = 2;
+  Config.Palette = Palette;
+  Config.Engine = &Engine;
+  Stream.Image = (uint8_t *)Image;
+  for(Frame = 0; Frame < 3000; Frame++)
+  {
+    Kernel = Kernels[rand() % 3];
+    CHECK(InterpInit(&Engine,Kernel,Kernel == KernelBicubic ? &Weights : NULL,8,8,OutSize,OutSize) == 0);
+    DrawScene(InMat,15 + rand() % 20,rand() % 8,rand() % 8,3 + rand() % 20,&Config.TempMax,&Config.TempMin);
+    Config.PixelFormat = rand() % 2 ? PixelRGB565 : PixelGray8;
+    Config.Background = rand() % 2 ? 20 : 0;
+    Config.Neighbors = rand() % 2 ? Neighbors8 : Neighbors4;
+    Stream.Size = Config.PixelFormat == PixelRGB565 ? 2 : 1;
+    Stream.Rows = 0;
+    Config.OutMat = FullMat;
+    CHECK(InfraredThermalImagingFused(&Config) == 0);
+    Config.OutMat = RowMat;
+    CHECK(InfraredThermalImagingStream(&Config,CopyRow,&Stream) == 0 && Stream.Rows == OutSize);
+    CHECK(memcmp(Image,FullMat,(uint32_t)OutSize * OutSize * Stream.Size) == 0);
+  }
+
+  //Engine for a taller input and a larger output than the 8*8 -> 32*32 configuration
+  CHECK(InterpInit(&Other,KernelBilinear,NULL,8,40,32,64) == 0);
+  Config.OutWidth = Config.OutHeight = 32;
+  Config.Engine = &Other;
+  Stream.Rows = 0;
+  CHECK(InfraredThermalImagingStream(&Config,CopyRow,&Stream) == 1 && Stream.Rows == 0);
+}
+
+/*Every frame of a batch (not a multiple of BatchGroup) gets the bytes of
+  InfraredThermalImagingFused() with its own tracker, gain and overlay over several rounds,
+  in both formats; a frame with too small a difference is reported and left untouched*/
+static void CheckBatch(uint8_t PixelFormat)
+{
+  static float InMat[BatchFrames][64];
+  static uint16_t OutMat[BatchFrames][OutSize * OutSize],RefMat[OutSize * OutSize];
+  static OtusTracker Tracker[2][BatchFrames];
+  static AutoGain Gain[2][BatchFrames];
+  static IsothermOverlay Overlay[2][BatchFrames];
+  float TempMax[BatchFrames],TempMin[BatchFrames];
+  uint8_t Status[BatchFrames];
+  InterpEngine Engine;
+  ThermalImagingBatch Batch;
+  ThermalImagingConfig Config;
+  uint16_t Round,Frame,Flat;
+  uint8_t k,Size = PixelFormat == PixelRGB565 ? 2 : 1;
+
+  srand(9);
+  CHECK(InterpInit(&Engine,KernelBilinear,NULL,8,8,OutSize,OutSize) == 0);
+  for(Frame = 0; Frame < BatchFrames; Frame++)
+  {
+    for(k = 0; k < 2; k++)
+    {
+      OtusTrackerInit(&Tracker[k][Frame]);
+      AutoGainInit(&Gain[k][Frame],AgcSmoothRange | AgcEqualize,2,16);
+      memset(&Overlay[k][Frame],0,sizeof(IsothermOverlay));
+      Overlay[k][Frame].Count = 1;
+      Overlay[k][Frame].Band[0].TempLow = 26 + Frame * 0.5f;
+      Overlay[k][Frame].Band[0].TempHigh = 28 + Frame * 0.5f;
+      Overlay[k][Frame].Band[0].Color = 0xF800 + Frame;
+      Overlay[k][Frame].Band[0].Gray = 250 - Frame;
+    }
+  }
+  memset(&Batch,0,sizeof(Batch));
+  Batch.Frames = BatchFrames;
+  Batch.InMat = InMat[0];
+  Batch.TempMax = TempMax;
+  Batch.TempMin = TempMin;
+  Batch.OutMat = OutMat;
+  Batch.Status = Status;
+  Batch.Tracker = Tracker[0];
+  Batch.Gain = Gain[0];
+  Batch.Overlay = Overlay[0];
+  Batch.InWidth = Batch.InHeight = 8;
+  Batch.OutWidth = Batch.OutHeight = OutSize;
+  Batch.Background = 20;
+  Batch.Neighbors = Neighbors8;
+  Batch.TempDiff = 2;
+  Batch.PixelFormat = PixelFormat;
+  Batch.Palette = Palette;
+  Batch.Engine = &Engine;
+  memset(&Config,0,sizeof(Config));
+  Config.InWidth = Config.InHeight = 8;
+  Config.OutWidth = Config.OutHeight = OutSize;
+  Config.Background = Batch.Background;
+  Config.Neighbors = Batch.Neighbors;
+  Config.TempDiff = Batch.TempDiff;
+  Config.PixelFormat = PixelFormat;
+  Config.Palette = Palette;
+  Config.Engine = &Engine;
+  Config.OutMat = RefMat;
+
+  for(Round = 0; Round < 6; Round++)
+  {
+    Flat = rand() % BatchFrames;
+    for(Frame = 0; Frame < BatchFrames; Frame++)
+    {
+      DrawScene(InMat[Frame],20 + rand() % 10,rand() % 8,rand() % 8,4 + rand() % 12,&TempMax[Frame],&TempMin[Frame]);
+      if(Frame == Flat)
+      {
+        //Two levels only: the difference is below TempDiff
+        for(k = 0; k < 64; k++) InMat[Frame][k] = 21 + (k & 1);
+        TempMax[Frame] = 22;
+        TempMin[Frame] = 21;
+      }
+    }
+    memset(OutMat,0xA5,sizeof(OutMat));
+    memset(Status,0xFF,sizeof(Status));
+    CHECK(InfraredThermalImagingBatch(&Batch) == 0);
+    for(Frame = 0; Frame < BatchFrames; Frame++)
+    {
+      Config.InMat = InMat[Frame];
+      Config.TempMax = TempMax[Frame];
+      Config.TempMin = TempMin[Frame];
+      Config.Tracker = &Tracker[1][Frame];
+      Config.Gain = &Gain[1][Frame];
+      Config.Overlay = &Overlay[1][Frame];
+      memset(RefMat,0xA5,sizeof(RefMat));
+      CHECK(InfraredThermalImagingFused(&Config) == 0);
+      CHECK(Status[Frame] == (Frame == Flat));
+      CHECK(memcmp((uint8_t *)OutMat + (uint32_t)Frame * OutSize * OutSize * Size,RefMat,(uint32_t)OutSize * OutSize * Size) == 0);
+    }
+  }
+}
+
+static void TestBatch(void)
+{
+  MakePalette();
+  CheckBatch(PixelRGB565);
+  CheckBatch(PixelGray8);
+}
+
+/*Every SIMD level gives the bytes of the scalar code, on random sizes and data so the
+  vector bodies and the scalar tails are both exercised*/
+static void TestSimdLevels(void)
+{
+  static uint8_t Gray[2][64 * 64];
+  static uint16_t Color[2][64 * 64];
+  uint8_t Bytes[2 * 300],GrayMat[2][300],InMat[32 * 8];
+  int16_t RawMat[2][300],Max,Min;
+  float Temp[300];
+  InterpEngine Engine;
+  uint16_t Run,n,i,InWidth,InHeight,OutWidth,OutHeight;
+  uint8_t Level,k,Levels[2] = {SimdSSE2,SimdAVX2};
+
+  MakePalette();
+  srand(5);
+  for(k = 0; k < 2; k++)
+  {
+    Level = SimdSelect(Levels[k]);
+    if(Level == SimdScalar) continue;        //No SIMD on this host, nothing to compare
+    for(Run = 0; Run < 2000; Run++)
+    {
+      n = 1 + rand() % 300;
+      for(i = 0; i < 2 * n; i++) Bytes[i] = rand();
+      SimdSelect(SimdScalar);
+      DecodeRawPixels(Bytes,RawMat[0],n);
+      SimdSelect(Level);
+      DecodeRawPixels(Bytes,RawMat[1],n);
+      CHECK(memcmp(RawMat[0],RawMat[1],2 * n) == 0);
+
+      Max = rand() % 400 - 100;
+      Min = Max - rand() % 300;
+      for(i = 0; i < n; i++)
+      {
+        RawMat[0][i] = Min - 20 + rand() % (Max - Min + 40);
+        Temp[i] = Min * 0.25f + (rand() % (Max - Min + 1)) * 0.25f;
+      }
+      SimdSelect(SimdScalar);
+      TransformGrayFixed(RawMat[0],GrayMat[0],n,1,Max,Min);
+      SimdSelect(Level);
+      TransformGrayFixed(RawMat[0],GrayMat[1],n,1,Max,Min);
+      CHECK(memcmp(GrayMat[0],GrayMat[1],n) == 0);
+      SimdSelect(SimdScalar);
+      TransformGray(Temp,GrayMat[0],n,1,Max * 0.25f,Min * 0.25f);
+      SimdSelect(Level);
+      TransformGray(Temp,GrayMat[1],n,1,Max * 0.25f,Min * 0.25f);
+      CHECK(memcmp(GrayMat[0],GrayMat[1],n) == 0);
+
+      for(i = 0; i < n; i++) GrayMat[0][i] = rand();
+      SimdSelect(SimdScalar);
+      PaletteMap(GrayMat[0],Color[0],Palette,n);
+      SimdSelect(Level);
+      PaletteMap(GrayMat[0],Color[1],Palette,n);
+      CHECK(memcmp(Color[0],Color[1],2 * n) == 0);
+
+      InWidth = 2 + rand() % 31;
+      InHeight = 2 + rand() % 7;
+      OutWidth = 1 + rand() % 64;
+      OutHeight = 1 + rand() % 64;
+      for(i = 0; i < InWidth * InHeight; i++) InMat[i] = rand();
+      CHECK(InterpInit(&Engine,KernelBilinear,NULL,InWidth,InHeight,OutWidth,OutHeight) == 0);
+      SimdSelect(SimdScalar);
+      InterpRun(&Engine,InMat,Gray[0]);
+      InterpRunTileColor(&Engine,InMat,Color[0],Palette,0,0,OutWidth,OutHeight);
+      SimdSelect(Level);
+      InterpRun(&Engine,InMat,Gray[1]);
+      InterpRunTileColor(&Engine,InMat,Color[1],Palette,0,0,OutWidth,OutHeight);
+      CHECK(memcmp(Gray[0],Gray[1],OutWidth * OutHeight) == 0);
+      CHECK(memcmp(Color[0],Color[1],2 * OutWidth * OutHeight) == 0);
+    }
+  }
+  SimdSelect(SimdAuto);
+}
+
+/*Images per millisecond of the fused pipeline and of the interpolation alone, 8*8 -> 55*55
+  bilinear, at every SIMD level*/
+static void Bench(void)
+{
+  static const char *Names[3] = {"scalar","SSE2","AVX2"};
+  static uint16_t OutMat[55 * 55];
+  uint8_t GrayMat[64];
+  InterpEngine Engine;
+  ThermalImagingConfig Config;
+  float InMat[64];
+  uint32_t Frame,Frames = 200000;
+  uint8_t Level,Format;
+  clock_t Start;
+  double Ms,InterpMs;
+
+  MakePalette();
+  srand(10);
+  InterpInit(&Engine,KernelBilinear,NULL,8,8,55,55);
+  memset(&Config,0,sizeof(Config));
+  DrawScene(InMat,22,3,4,10,&Config.TempMax,&Config.TempMin);
+  TransformGray(InMat,GrayMat,8,8,Config.TempMax,Config.TempMin);
+  Config.InMat = InMat;
+  Config.OutMat = OutMat;
+  Config.InWidth = Config.InHeight = 8;
+  Config.OutWidth = Config.OutHeight = 55;
+  Config.Background = 20;
+  Config.TempDiff = 2;
+  Config.Palette = Palette;
+  Config.Engine = &Engine;
+  for(Level = SimdScalar; Level <= SimdAVX2; Level++)
+  {
+    if(SimdSelect(Level) != Level) continue;
+    for(Format = 0; Format < 2; Format++)
+    {
+      Config.PixelFormat = Format ? PixelRGB565 : PixelGray8;
+      Start = clock();
+      for(Frame = 0; Frame < Frames; Frame++) InfraredThermalImagingFused(&Config);
+      Ms = (double)(clock() - Start) * 1000 / CLOCKS_PER_SEC;
+      Start = clock();
+      for(Frame = 0; Frame < Frames; Frame++)
+      {
+        if(Format) InterpRunTileColor(&Engine,GrayMat,OutMat,Palette,0,0,55,55);
+        else       InterpRun(&Engine,GrayMat,(uint8_t *)OutMat);
+      }
+      InterpMs = (double)(clock() - Start) * 1000 / CLOCKS_PER_SEC;
+      printf("%-6s %-6s pipeline %4.0f images/ms, interpolation %4.0f images/ms\n",
+             Names[Level],Format ? "RGB565" : "Gray8",Frames / Ms,Frames / InterpMs);
+    }
+  }
+  SimdSelect(SimdAuto);
+}
+
+int main(int argc,char **argv)
+{
+  if(argc > 1 && strcmp(argv[1],"bench") == 0)
+  {
+    Bench();
+    return 0;
+  }
+  RUN(TestTiles);
+  RUN(TestSuperResFade);
+  RUN(TestBicubicWeights);
+  RUN(TestBilinearTable);
+  RUN(TestFusedStaged);
+  RUN(TestGrayFixed);
+  RUN(TestOtusTracker);
+  RUN(TestBackgroundFilter);
+  RUN(TestMissingPalette);
+  RUN(TestStream);
+  RUN(TestBatch);
+  RUN(TestSimdLevels);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,245 @@
+/*****************************************************************
+File:             test_pool.cpp
+Author:           BESTMODULES
+Description:      Host tests of ThermalImagingPool: per-sensor order, drain(), dropped frames
+                  and statistics. "./test_pool bench" measures the throughput for 1 ~ N workers.
+History：
+V1.0.1   -- initial version；2026-10-19
+******************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include "ThermalImagingPool.h"
+#include "check.h"
+
+#define Sensors  16
+#define OutSize  56
+
+/*State shared with the sink of the ordering test*/
+struct Delivery
+{
+  uint32_t next[Sensors];           //Sequence expected next for every sensor
+  std::atomic<uint32_t> frames;
+  std::atomic<uint32_t> disorder;   //Frames out of order or with the data of another frame
+};
+
+/*Frame Sequence of a sensor: TempMax encodes the sequence so the sink can check its data*/
+static void DrawFrame(float *tempMat, uint32_t sequence, float &tempMax, float &tempMin)
+{
+  for(uint8_t i = 0; i < 64; i++) tempMat[i] = 20 + (i * 7 + sequence) % 13 * 0.25f;
+  tempMat[sequence % 64] = 40 + (sequence % 1000) * 0.25f;
+  tempMax = tempMat[sequence % 64];
+  tempMin = 20;
+  for(uint8_t i = 0; i < 64; i++) if(tempMat[i] < tempMin) tempMin = tempMat[i];
+}
+
+/*Only the worker that runs a sensor touches next[sensor], one at a time*/
+static void CheckOrder(uint16_t sensor, uint32_t sequence, uint8_t result, ThermalImagingConfig *config, void *arg)
+{
+  Delivery *delivery = (Delivery *)arg;
+
+  if(result != 0 || sequence != delivery->next[sensor] || config->TempMax != 40 + (sequence % 1000) * 0.25f) delivery->disorder++;
+  delivery->next[sensor] = sequence + 1;
+  delivery->frames++;
+}
+
+/*Configuration of one 8*8 -> 56*56 gray sensor*/
+static ThermalImagingConfig MakeConfig(InterpEngine &engine, uint8_t *outMat)
+{
+  ThermalImagingConfig config;
+
+  memset(&config, 0, sizeof(config));
+  config.InWidth = config.InHeight = 8;
+  config.OutWidth = config.OutHeight = OutSize;
+  config.Background = 20;
+  config.TempDiff = 2;
+  config.PixelFormat = PixelGray8;
+  config.Engine = &engine;
+  config.OutMat = outMat;
+  return config;
+}
+
+/*16 sensors * 1000 frames on 4 workers: every frame arrives once, in order, with its own
+  data; the statistics count every frame of every stage*/
+static void TestOrder(void)
+{
+  static uint8_t outMat[Sensors][OutSize * OutSize];
+  InterpEngine engine;
+  Delivery delivery;
+  ThermalImagingPoolStats stats;
+  float tempMat[64], tempMax, tempMin;
+  uint32_t frame;
+  uint16_t s;
+
+  CHECK(InterpInit(&engine, KernelBilinear, NULL, 8, 8, OutSize, OutSize) == 0);
+  memset(delivery.next, 0, sizeof(delivery.next));
+  delivery.frames = 0;
+  delivery.disorder = 0;
+  {
+    ThermalImagingPool pool(CheckOrder, &delivery, 4, 8);
+    for(s = 0; s < Sensors; s++) CHECK(pool.addSensor(MakeConfig(engine, outMat[s])) == s);
+    for(frame = 0; frame < 1000; frame++)
+    {
+      for(s = 0; s < Sensors; s++)
+      {
+        DrawFrame(tempMat, frame, tempMax, tempMin);
+        while(!pool.submit(s, tempMat, tempMax, tempMin)) std::this_thread::yield();
+      }
+    }
+    pool.drain();
+    CHECK(delivery.frames == Sensors * 1000);
+    pool.getStats(stats);
+    for(s = 0; s < PoolStages; s++)
+    {
+      CHECK(stats.stage[s].count == Sensors * 1000);
+      CHECK(stats.stage[s].maxUs <= stats.stage[s].totalUs);
+    }
+    CHECK(pool.submit(Sensors, tempMat, tempMax, tempMin) == false);
+  }
+  CHECK(delivery.disorder == 0);
+  for(s = 0; s < Sensors; s++) CHECK(delivery.next[s] == 1000);
+}
+
+/*Sink that holds the worker until the test opens the gate*/
+struct Gate
+{
+  std::mutex lock;
+  std::condition_variable changed;
+  bool open;
+  uint32_t entered;
+  uint32_t sequence[8];
+};
+
+static void WaitGate(uint16_t sensor, uint32_t sequence, uint8_t result, ThermalImagingConfig *config, void *arg)
+{
+  Gate *gate = (Gate *)arg;
+  std::unique_lock<std::mutex> guard(gate->lock);
+
+  (void)sensor;
+  (void)result;
+  (void)config;
+  if(gate->entered < 8) gate->sequence[gate->entered] = sequence;
+  gate->entered++;
+  gate->changed.notify_all();
+  gate->changed.wait(guard, [gate]{ return gate->open; });
+}
+
+/*One worker, queue depth 2: while the first frame is in the sink two more wait and the
+  next ones are dropped without taking a sequence number; drain() returns only after the
+  gate opens and clearStats() resets the counters*/
+static void TestDrop(void)
+{
+  static uint8_t outMat[OutSize * OutSize];
+  InterpEngine engine;
+  Gate gate;
+  ThermalImagingPoolStats stats;
+  std::atomic<bool> drained(false);
+  float tempMat[64], tempMax, tempMin;
+
+  CHECK(InterpInit(&engine, KernelBilinear, NULL, 8, 8, OutSize, OutSize) == 0);
+  gate.open = false;
+  gate.entered = 0;
+  ThermalImagingPool pool(WaitGate, &gate, 1, 2);
+  CHECK(pool.addSensor(MakeConfig(engine, outMat)) == 0);
+  DrawFrame(tempMat, 0, tempMax, tempMin);
+  CHECK(pool.submit(0, tempMat, tempMax, tempMin));
+  {
+    std::unique_lock<std::mutex> guard(gate.lock);
+    gate.changed.wait(guard, [&gate]{ return gate.entered == 1; });
+  }
+  CHECK(pool.submit(0, tempMat, tempMax, tempMin));
+  CHECK(pool.submit(0, tempMat, tempMax, tempMin));
+  CHECK(pool.submit(0, tempMat, tempMax, tempMin) == false);
+  CHECK(pool.submit(0, tempMat, tempMax, tempMin) == false);
+
+  std::thread waiter([&pool, &drained]{ pool.drain(); drained = true; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(!drained);
+  {
+    std::lock_guard<std::mutex> guard(gate.lock);
+    gate.open = true;
+  }
+  gate.changed.notify_all();
+  waiter.join();
+  CHECK(drained);
+  CHECK(gate.entered == 3);
+  CHECK(gate.sequence[0] == 0 && gate.sequence[1] == 1 && gate.sequence[2] == 2);
+
+  pool.getStats(stats);
+  CHECK(stats.dropped == 2);
+  CHECK(stats.stolen == 0);
+  CHECK(stats.stage[PoolStageImaging].count == 3);
+  CHECK(stats.stage[PoolStageSink].count == 3);
+  CHECK(stats.stage[PoolStageSink].maxUs >= 15000);      //The first frame waited at the gate
+  pool.clearStats();
+  pool.getStats(stats);
+  CHECK(stats.dropped == 0);
+  for(uint8_t s = 0; s < PoolStages; s++) CHECK(stats.stage[s].count == 0 && stats.stage[s].totalUs == 0 && stats.stage[s].maxUs == 0);
+}
+
+static void CountFrame(uint16_t sensor, uint32_t sequence, uint8_t result, ThermalImagingConfig *config, void *arg)
+{
+  (void)sensor;
+  (void)sequence;
+  (void)result;
+  (void)config;
+  ((std::atomic<uint32_t> *)arg)->fetch_add(1);
+}
+
+/*Frames per second of 64 sensors imaged 8*8 -> 56*56 RGB565, for 1 ~ hardware threads workers*/
+static void Bench(void)
+{
+  static uint16_t outMat[64][OutSize * OutSize];
+  static unsigned int palette[MaxGrayscale];
+  InterpEngine engine;
+  ThermalImagingConfig config;
+  std::atomic<uint32_t> frames;
+  float tempMat[64], tempMax, tempMin;
+  unsigned workers, maxWorkers = std::thread::hardware_concurrency();
+  double single = 0;
+
+  if(maxWorkers == 0) maxWorkers = 1;
+  InterpInit(&engine, KernelBilinear, NULL, 8, 8, OutSize, OutSize);
+  for(uint16_t i = 0; i < MaxGrayscale; i++) palette[i] = i;
+  DrawFrame(tempMat, 3, tempMax, tempMin);
+  for(workers = 1; workers <= maxWorkers; workers++)
+  {
+    frames = 0;
+    ThermalImagingPool pool(CountFrame, &frames, workers, 8);
+    for(uint16_t s = 0; s < 64; s++)
+    {
+      config = MakeConfig(engine, (uint8_t *)outMat[s]);
+      config.PixelFormat = PixelRGB565;
+      config.Palette = palette;
+      pool.addSensor(config);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t frame = 0; frame < 2000; frame++)
+    {
+      for(uint16_t s = 0; s < 64; s++)
+      {
+        while(!pool.submit(s, tempMat, tempMax, tempMin)) std::this_thread::yield();
+      }
+    }
+    pool.drain();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = frames / seconds;
+    if(workers == 1) single = rate;
+    printf("workers %2u: %9.0f frames/s  speedup %.2f\n", workers, rate, rate / single);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if(argc > 1 && strcmp(argv[1], "bench") == 0)
+  {
+    Bench();
+    return 0;
+  }
+  RUN(TestOrder);
+  RUN(TestDrop);
+  return CHECK_RESULT();
+}
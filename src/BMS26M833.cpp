@@ -9,7 +9,6 @@ V1.0.1   -- initial version；2023-05-22；Arduino IDE :v1.8.15
 
 uint8_t dataBuff[128];   //Array for storing data
 int DataCnt = 0;
-extern float TempMax,TempMin;
 
 /**********************************************************
 Description: Constructor
@@ -115,26 +114,11 @@ Others:      none
 **********************************************************/
 void BMS26M833::readPixels(float tempBuff[])
 {
-      int cnt=0;
-      uint8_t buf1[32]={0},buf2[32]={0},buf3[32]={0},buf4[32]={0};
-      readReg(REG_T01L,buf1, 32);
-      readReg(REG_T17L,buf2, 32);
-      readReg(REG_T33L,buf3, 32);
-      readReg(REG_T49L,buf4, 32);
-      for(int i =0;i<32;i++)
-      {
-          dataBuff[cnt] = buf1[i];
-          dataBuff[cnt+32] = buf2[i];
-          dataBuff[cnt+64] = buf3[i];
-          dataBuff[cnt+96] = buf4[i];
-          cnt++; 
-      }
-      cnt = 0;
+      int16_t rawBuff[64];
+      readRawFrame(rawBuff);
       for(int pixels_cnt = 0; pixels_cnt < 64; pixels_cnt++)
       {
-          tempBuff[pixels_cnt] = (uint16_t)dataBuff[cnt+1] <<8  | dataBuff[cnt];
-          tempBuff[pixels_cnt] *= 0.25;
-          cnt += 2;
+          tempBuff[pixels_cnt] = rawBuff[pixels_cnt] * 0.25;
       } 
 }
 /**********************************************************
@@ -147,34 +131,152 @@ Others:      none
 **********************************************************/
 void BMS26M833::readPixelsAndMaximum(float tempBuff[], float &maxValue, float &minValue)
 {
-      int cnt=0;
-      uint8_t buf1[32]={0},buf2[32]={0},buf3[32]={0},buf4[32]={0};
+      int16_t rawBuff[64];
       maxValue = 0;
       minValue = 80;
-      readReg(REG_T01L,buf1, 32);
-      readReg(REG_T17L,buf2, 32);
-      readReg(REG_T33L,buf3, 32);
-      readReg(REG_T49L,buf4, 32);
-
-      for(int i =0;i<32;i++)
-      {
-          dataBuff[cnt] = buf1[i];
-          dataBuff[cnt+32] = buf2[i];
-          dataBuff[cnt+64] = buf3[i];
-          dataBuff[cnt+96] = buf4[i];
-          cnt++; 
-      }
-      cnt = 0;
+      readRawFrame(rawBuff);
       for(int pixels_cnt = 0; pixels_cnt < 64; pixels_cnt++)
       {
-          tempBuff[pixels_cnt] = (uint16_t)dataBuff[cnt+1] <<8  | dataBuff[cnt];
-          tempBuff[pixels_cnt] *= 0.25;
-          cnt += 2;
+          tempBuff[pixels_cnt] = rawBuff[pixels_cnt] * 0.25;
           if(tempBuff[pixels_cnt] > maxValue) maxValue = tempBuff[pixels_cnt];
           if(tempBuff[pixels_cnt] < minValue) minValue = tempBuff[pixels_cnt];
       }
 }
 /**********************************************************
+Description: read raw temperature Pixels and Maximum value(unit:0.25℃)
+Parameters:  rawBuff[]:Store temperature data from the sensor 
+             maxValue:Store temperature max data
+             minValue:Store temperature min data
+Return:      none    
+Others:      The 12-bit two's complement register values are returned without 
+             float conversion, for TransformGrayFixed()
+**********************************************************/
+void BMS26M833::readRawPixelsAndMaximum(int16_t rawBuff[], int16_t &maxValue, int16_t &minValue)
+{
+      maxValue = -2048;
+      minValue = 2047;
+      readRawFrame(rawBuff);
+      for(int pixels_cnt = 0; pixels_cnt < 64; pixels_cnt++)
+      {
+          if(rawBuff[pixels_cnt] > maxValue) maxValue = rawBuff[pixels_cnt];
+          if(rawBuff[pixels_cnt] < minValue) minValue = rawBuff[pixels_cnt];
+      }
+}
+/**********************************************************
+Description: read temperature Pixels and Maximum value, and locate the hottest point(unit:℃)
+Parameters:  tempBuff[]:Store temperature data from the sensor 
+             maxValue:Store temperature max data
+             minValue:Store temperature min data
+             hotspot:Store the position of the hottest point
+Return:      none    
+Others:      The maximum is found while the frame is decoded, then only its 3*3 
+             neighbourhood is read again, in 0.25℃ integers:
+             1. peakX/peakY: vertex of the parabola through the maximum and its 
+                two neighbours on each axis, within half a pixel of the maximum.
+             2. centroidX/centroidY: centroid of the neighbourhood weighted by 
+                the height above its lowest pixel.
+             Neighbours outside the 8*8 frame are left out.
+**********************************************************/
+void BMS26M833::readPixelsAndHotspot(float tempBuff[], float &maxValue, float &minValue, BMS26M833Hotspot &hotspot)
+{
+      int16_t rawBuff[64];
+      int16_t rawMax = -2048,rawMin = 2047;
+      int16_t cell[3][3];
+      int32_t den,diff,floorValue,weight,sum,sumX,sumY;
+      int8_t row,col,dx,dy;
+      uint8_t peak = 0;
+      readRawFrame(rawBuff);
+      for(int pixels_cnt = 0; pixels_cnt < 64; pixels_cnt++)
+      {
+          tempBuff[pixels_cnt] = rawBuff[pixels_cnt] * 0.25;
+          if(rawBuff[pixels_cnt] > rawMax) { rawMax = rawBuff[pixels_cnt]; peak = pixels_cnt; }
+          if(rawBuff[pixels_cnt] < rawMin) rawMin = rawBuff[pixels_cnt];
+      }
+      maxValue = rawMax * 0.25;
+      minValue = rawMin * 0.25;
+
+      //3*3 neighbourhood, the centre stands in for the pixels outside the frame
+      row = peak >> 3;
+      col = peak & 7;
+      floorValue = rawMax;
+      for(dy = -1; dy <= 1; dy++)
+      {
+          for(dx = -1; dx <= 1; dx++)
+          {
+              if(row + dy < 0 || row + dy > 7 || col + dx < 0 || col + dx > 7) cell[dy + 1][dx + 1] = rawMax;
+              else
+              {
+                  cell[dy + 1][dx + 1] = rawBuff[(row + dy) * 8 + col + dx];
+                  if(cell[dy + 1][dx + 1] < floorValue) floorValue = cell[dy + 1][dx + 1];
+              }
+          }
+      }
+      hotspot.index = peak;
+      hotspot.peakValue = rawMax * 16;
+
+      //Parabola vertex: offset = (L - R) / (2 * (L - 2C + R)), peak = C - (L - R)^2 / (8 * (L - 2C + R))
+      //in 32 bits, (L - R)^2 of the 12-bit values does not fit the 16-bit int of AVR
+      hotspot.peakX = col * 256;
+      den = (int32_t)cell[1][0] - 2 * (int32_t)rawMax + cell[1][2];
+      if(den < 0 && col > 0 && col < 7)
+      {
+          diff = (int32_t)cell[1][0] - cell[1][2];
+          hotspot.peakX += 128 * diff / den;
+          hotspot.peakValue -= 2 * diff * diff / den;
+      }
+      hotspot.peakY = row * 256;
+      den = (int32_t)cell[0][1] - 2 * (int32_t)rawMax + cell[2][1];
+      if(den < 0 && row > 0 && row < 7)
+      {
+          diff = (int32_t)cell[0][1] - cell[2][1];
+          hotspot.peakY += 128 * diff / den;
+          hotspot.peakValue -= 2 * diff * diff / den;
+      }
+
+      //Centroid of the height above the lowest neighbour
+      sum = sumX = sumY = 0;
+      for(dy = -1; dy <= 1; dy++)
+      {
+          for(dx = -1; dx <= 1; dx++)
+          {
+              if(row + dy < 0 || row + dy > 7 || col + dx < 0 || col + dx > 7) continue;
+              weight = cell[dy + 1][dx + 1] - floorValue;
+              sum  += weight;
+              sumX += weight * dx;
+              sumY += weight * dy;
+          }
+      }
+      hotspot.centroidX = col * 256 + (sum == 0 ? 0 : sumX * 256 / sum);
+      hotspot.centroidY = row * 256 + (sum == 0 ? 0 : sumY * 256 / sum);
+}
+/**********************************************************
+Description: Check the pixels against their own thresholds when the interrupt fires
+Parameters:  map: Threshold of every pixel, set by setInterruptLevels(map)
+             rawBuff[]:Store temperature data from the sensor(unit:0.25℃), 
+                       only filled when the interrupt is asserted
+Return:      Pixels in alarm, listed in map.Alarm
+Others:      While the INT pin is idle no pixel is inside the band, so every 
+             alarm is cleared without an I2C transfer. Otherwise the interrupt
+             table and the frame are read, only the flagged pixels are checked
+             (ThresholdMapEvaluate) and the interrupt is cleared.
+**********************************************************/
+uint8_t BMS26M833::readPixelAlarms(ThresholdMap &map, int16_t rawBuff[])
+{
+      uint8_t intTable[8];
+      int16_t maxValue,minValue;
+      if(getINT() != 0)
+      {
+          map.Count = 0;
+          memset(map.Alarm, 0, sizeof(map.Alarm));
+          return 0;
+      }
+      getINTTable(intTable);
+      readRawPixelsAndMaximum(rawBuff, maxValue, minValue);
+      ThresholdMapEvaluate(&map, rawBuff, intTable);
+      setStatusClear();
+      return map.Count;
+}
+/**********************************************************
 Description: get Interrupt Table
 Parameters:  buf[]: the returned data will be stored
              size: size Optional number of bytes to read. Default is 8 bytes.
@@ -367,6 +469,22 @@ void BMS26M833::setInterruptLevels(float high, float low, float hysteresis)
       writeReg(REG_IHYSL, hysteresisTemp & 0xFF);
       writeReg(REG_IHYSH, hysteresisTemp >> 8);
 }
+/**********************************************************
+Description: Set the interrupt levels to cover a per-pixel threshold map
+Parameters:  map: Threshold of every pixel
+Return:      none
+Others:      The sensor has one band for all pixels, it is set to the loosest 
+             thresholds of the map (ThresholdMapBand) without hysteresis, so 
+             the interrupt fires whenever a pixel may be in alarm and 
+             readPixelAlarms() can sort them out. Set it again after changing
+             the map, enable the interrupt with setINT(true).
+**********************************************************/
+void BMS26M833::setInterruptLevels(const ThresholdMap &map)
+{
+      int16_t high,low;
+      ThresholdMapBand(&map, &high, &low);
+      setInterruptLevels(high * 0.25, low * 0.25, 0);
+}
 
 /**********************************************************
 Description: set Status Clear
@@ -474,6 +592,25 @@ void BMS26M833::clearBuf()
       } 
 }
 /**********************************************************
+Description: read the 64 pixel registers
+Parameters:  rawBuff[]:Store temperature data from the sensor(unit:0.25℃)
+Return:      none    
+Others:      The frame is read in four 32-byte transfers (T01L, T17L, T33L, 
+             T49L) and the 12-bit two's complement values are sign-extended.
+**********************************************************/
+void BMS26M833::readRawFrame(int16_t rawBuff[])
+{
+      uint8_t buf[32];
+      for(uint8_t part = 0; part < 4; part++)
+      {
+          readReg(REG_T01L + part * 32, buf, 32);
+          for(uint8_t i = 0; i < 16; i++)
+          {
+              rawBuff[part * 16 + i] = (int16_t)((uint16_t)buf[2*i+1] <<12  | (uint16_t)buf[2*i] << 4) >> 4;
+          }
+      }
+}
+/**********************************************************
 Description: writeBytes
 Parameters:  wbuf[]:Variables for storing Data to be sent
              wlen:Length of data sent  
@@ -11,6 +11,7 @@ V1.0.1   -- initial version；2023-05-22；Arduino IDE :v1.8.15
 
 #include <Wire.h>
 #include <Arduino.h>
+#include "ThermalAnalytics.h"
 
 //BMS26M833 IIC Address
  
@@ -61,6 +62,17 @@ const uint8_t BMS26M833_IICADDR = 0x68;//AD_SELECT to low
 #define    REG_T33L      0xC0
 #define    REG_T49L      0xE0
 
+/*Hottest pixel of a frame located with sub-pixel precision (see readPixelsAndHotspot)*/
+typedef struct
+{
+    uint8_t index;          //Pixel number of the maximum (0~63, row * 8 + column)
+    int16_t peakX;          //Column of the quadratic-fit peak (unit:1/256 pixel, pixel centres at 0,256...1792)
+    int16_t peakY;          //Row of the quadratic-fit peak (unit:1/256 pixel)
+    int16_t centroidX;      //Column of the weighted centroid of the 3*3 neighbourhood (unit:1/256 pixel)
+    int16_t centroidY;      //Row of the weighted centroid of the 3*3 neighbourhood (unit:1/256 pixel)
+    int16_t peakValue;      //Temperature of the quadratic-fit peak (unit:1/64℃)
+}BMS26M833Hotspot;
+
 class BMS26M833
 {
    public:
@@ -73,6 +85,8 @@ class BMS26M833
         void readReg(uint8_t addr, uint8_t rBuf[], uint8_t rLen);       
         void readPixels(float tempBuff[]);
         void readPixelsAndMaximum(float tempBuff[], float &maxVlaue, float &minVlaue);
+        void readRawPixelsAndMaximum(int16_t rawBuff[], int16_t &maxValue, int16_t &minValue);
+        void readPixelsAndHotspot(float tempBuff[], float &maxValue, float &minValue, BMS26M833Hotspot &hotspot);
         //INT0~INT7     0x10~0x17
         void getINTTable(uint8_t buf[], uint8_t size = 8);        
         uint8_t getOperationMode();
@@ -94,6 +108,9 @@ class BMS26M833
         void setInterruptLevels(float high, float low);
         // this will manually set hysteresis
         void setInterruptLevels(float high, float low, float hysteresis);
+        // this will set the loosest band of a per-pixel threshold map
+        void setInterruptLevels(const ThresholdMap &map);
+        uint8_t readPixelAlarms(ThresholdMap &map, int16_t rawBuff[]);
         void setStatusClear();
         void setAverageOutputMode(uint8_t mode = ONE_MOVE_OUTPUT);
         void setOperationMode(uint8_t mode);
@@ -105,6 +122,7 @@ class BMS26M833
         void writeBytes(uint8_t wbuf[], uint8_t wlen);
         void writeRegBit(uint8_t addr,uint8_t bitNum, uint8_t bitValue);
         void readBytes(uint8_t rbuf[], uint8_t rlen);
+        void readRawFrame(int16_t rawBuff[]);
         uint16_t readRawThermistorTemp();
         uint16_t convertIntToUint16(int16_t val);
         uint16_t convertFloatToSigned12(float val);
@@ -0,0 +1,758 @@
+/*****************************************************************
+File:             ThermalAnalytics.c
+Author:           BESTMODULES
+Description:      Object analysis on the 8*8 frames of the BMS26M833, in integer arithmetic
+                  on the raw pixels of readRawPixelsAndMaximum() (unit:0.25℃).
+History：
+V1.0.1   -- initial version；2026-10-19；Arduino IDE :v1.8.15
+******************************************************************/
+#include "ThermalAnalytics.h"
+
+static uint8_t BlobFind(uint8_t *Parent,uint8_t Label);
+static void BlobMerge(ThermalBlob *Into,const ThermalBlob *From);
+static void TrackEmit(ObjectTracker *Tracker,uint8_t Type,const ThermalTrack *Object,int16_t FromX,int16_t FromY);
+static int8_t LineSide(const LineCounter *Counter,int16_t X,int16_t Y);
+static uint16_t IntSqrt(uint32_t Value);
+
+/**********************************************************
+Description: Label the connected blobs of a frame.
+Input:       *RawMat: 8*8 frame (unit:0.25℃), e.g. from readRawPixelsAndMaximum().
+             *Mask: Optional 64 flags, nonzero marks a target pixel. NULL: a pixel is a
+                    target when it is above Threshold.
+             Threshold: Target temperature (unit:0.25℃), ignored when Mask is given.
+             Neighbors: Neighbors4 (up, down, left, right) or Neighbors8 (also the diagonals).
+             MinArea: Blobs with fewer pixels are dropped (0 or 1: keep all).
+Output:      *List: Blobs of the frame, largest first.
+Return:      0: Success  1: Parameter error
+Others:      Single raster pass: a target pixel takes the label of its upper and left
+             neighbours, and when they carry different labels the two sets are joined
+             in the union-find Parent[] and their statistics merged at once, so the
+             roots are complete when the pass ends. Only the labels of the previous
+             and the current row are kept.
+**********************************************************/
+uint8_t BlobLabel(const int16_t *RawMat,const uint8_t *Mask,int16_t Threshold,uint8_t Neighbors,uint8_t MinArea,BlobList *List)
+{
+  uint8_t Labels[2][FrameWidth];
+  uint8_t *Row,*Above;
+  uint8_t Near[4];
+  uint8_t NearCount,Label,Root,Next = 0;
+  uint8_t x,y,i,k;
+  ThermalBlob *Entry;
+  ThermalBlob Key;
+
+  if(RawMat == NULL || List == NULL || (Neighbors != Neighbors4 && Neighbors != Neighbors8))
+  {
+    return 1;
+  }
+  memset(Labels,0xff,sizeof(Labels));
+  for(y = 0; y < FrameHeight; y++)
+  {
+    Row = Labels[y & 1];
+    Above = Labels[(y + 1) & 1];
+    for(x = 0; x < FrameWidth; x++)
+    {
+      i = y * FrameWidth + x;
+      if(Mask != NULL ? Mask[i] == 0 : RawMat[i] <= Threshold)
+      {
+        Row[x] = 0xff;
+        continue;
+      }
+      NearCount = 0;
+      if(x > 0) Near[NearCount++] = Row[x - 1];
+      if(y > 0)
+      {
+        Near[NearCount++] = Above[x];
+        if(Neighbors == Neighbors8)
+        {
+          if(x > 0) Near[NearCount++] = Above[x - 1];
+          if(x < FrameWidth - 1) Near[NearCount++] = Above[x + 1];
+        }
+      }
+      Label = 0xff;
+      for(k = 0; k < NearCount; k++)
+      {
+        if(Near[k] == 0xff) continue;
+        Root = BlobFind(List->Parent,Near[k]);
+        if(Label == 0xff) Label = Root;
+        else if(Root != Label)
+        {
+          //The older label stays the root
+          if(Root < Label) { Root ^= Label; Label ^= Root; Root ^= Label; }
+          List->Parent[Root] = Label;
+          BlobMerge(&List->Blob[Label],&List->Blob[Root]);
+        }
+      }
+      if(Label == 0xff)
+      {
+        Label = Next++;                     //At most 4 new labels per row, so Next stays below MaxBlobs
+        List->Parent[Label] = Label;
+        Entry = &List->Blob[Label];
+        Entry->Area = 0;
+        Entry->Left = Entry->Right = x;
+        Entry->Top = Entry->Bottom = y;
+        Entry->PeakIndex = i;
+        Entry->Peak = RawMat[i];
+        Entry->CentroidX = Entry->CentroidY = 0;
+      }
+      Row[x] = Label;
+      Entry = &List->Blob[Label];
+      Entry->Area++;
+      if(x < Entry->Left) Entry->Left = x;
+      if(x > Entry->Right) Entry->Right = x;
+      Entry->Bottom = y;
+      if(RawMat[i] > Entry->Peak)
+      {
+        Entry->Peak = RawMat[i];
+        Entry->PeakIndex = i;
+      }
+      Entry->CentroidX += x;                //Sums of the coordinates until the pass ends
+      Entry->CentroidY += y;
+    }
+  }
+
+  //Keep the roots, then sort them by area (insertion sort, stable)
+  List->Count = 0;
+  for(Label = 0; Label < Next; Label++)
+  {
+    if(List->Parent[Label] != Label || List->Blob[Label].Area < MinArea) continue;
+    Entry = &List->Blob[List->Count++];
+    *Entry = List->Blob[Label];
+    Entry->CentroidX = (int32_t)Entry->CentroidX * 256 / Entry->Area;
+    Entry->CentroidY = (int32_t)Entry->CentroidY * 256 / Entry->Area;
+  }
+  for(i = 1; i < List->Count; i++)
+  {
+    Key = List->Blob[i];
+    for(k = i; k > 0 && List->Blob[k - 1].Area < Key.Area; k--)
+    {
+      List->Blob[k] = List->Blob[k - 1];
+    }
+    List->Blob[k] = Key;
+  }
+  return 0;
+}
+
+/**********************************************************
+Description: Initialize the object tracker.
+Input:       *Tracker: Tracker to be initialized.
+             MaxDistance: Farthest a blob may be from the predicted position of an object
+                          to be taken as that object (unit:1/256 pixel), e.g. 512 for 
+                          people walking under a ceiling sensor at FPS_10.
+             ConfirmFrames: Frames a new object must be found in before it is reported 
+                            (0 or 1: at once), filters blobs that flicker for one frame.
+             MaxMissed: Frames an object may be lost before it is reported gone.
+Output:      none
+Return:      none
+Others:      none
+**********************************************************/
+void ObjectTrackerInit(ObjectTracker *Tracker,uint16_t MaxDistance,uint8_t ConfirmFrames,uint8_t MaxMissed)
+{
+  memset(Tracker,0,sizeof(ObjectTracker));
+  Tracker->MaxDistance = MaxDistance;
+  Tracker->ConfirmFrames = ConfirmFrames == 0 ? 1 : ConfirmFrames;
+  Tracker->MaxMissed = MaxMissed;
+  Tracker->NextId = 1;
+}
+
+/**********************************************************
+Description: Follow the objects into a new frame.
+Input:       *Tracker: Tracker initialized by ObjectTrackerInit().
+             *List: Blobs of the new frame from BlobLabel().
+Output:      Tracker -> Event[0 ~ EventCount - 1]: What changed in this frame.
+Return:      0: Success  1: Parameter error
+Others:      Greedy nearest-neighbour assignment: the closest free pair of object
+             (at its position predicted from the last displacement) and blob within
+             MaxDistance is joined first, until no pair is left. This costs
+             MaxTracks * Count distances per joined pair and needs no memory 
+             beyond the tracker. Blobs left over start new objects in free slots,
+             largest first; when every slot is taken they are ignored.
+**********************************************************/
+uint8_t ObjectTrackerUpdate(ObjectTracker *Tracker,const BlobList *List)
+{
+  uint8_t Matched[MaxTracks];
+  uint32_t Used = 0;
+  uint32_t Gate,Best,Distance;
+  int32_t dx,dy;
+  uint8_t t,b,BestTrack = 0,BestBlob = 0,Confirmed;
+  int16_t FromX,FromY;
+  ThermalTrack *Object;
+  const ThermalBlob *Entry;
+
+  if(Tracker == NULL || List == NULL || List->Count > MaxBlobs)
+  {
+    return 1;
+  }
+  Tracker->EventCount = 0;
+  memset(Matched,0xff,sizeof(Matched));
+  Gate = (uint32_t)Tracker->MaxDistance * Tracker->MaxDistance;
+  while(1)
+  {
+    Best = 0xffffffff;
+    for(t = 0; t < MaxTracks; t++)
+    {
+      Object = &Tracker->Track[t];
+      if(Object->Id == 0 || Matched[t] != 0xff) continue;
+      for(b = 0; b < List->Count; b++)
+      {
+        if(Used & ((uint32_t)1 << b)) continue;
+        dx = (int32_t)List->Blob[b].CentroidX - (Object->X + Object->VelocityX);
+        dy = (int32_t)List->Blob[b].CentroidY - (Object->Y + Object->VelocityY);
+        Distance = (uint32_t)(dx * dx + dy * dy);
+        if(Distance < Best)
+        {
+          Best = Distance;
+          BestTrack = t;
+          BestBlob = b;
+        }
+      }
+    }
+    if(Best > Gate) break;
+    Matched[BestTrack] = BestBlob;
+    Used |= (uint32_t)1 << BestBlob;
+  }
+
+  for(t = 0; t < MaxTracks; t++)
+  {
+    Object = &Tracker->Track[t];
+    if(Object->Id == 0) continue;
+    Confirmed = Object->Hits >= Tracker->ConfirmFrames;
+    if(Matched[t] == 0xff)
+    {
+      Object->VelocityX = 0;
+      Object->VelocityY = 0;
+      if(++Object->Missed > Tracker->MaxMissed)
+      {
+        if(Confirmed) TrackEmit(Tracker,TrackExit,Object,Object->StartX,Object->StartY);
+        Object->Id = 0;
+      }
+      continue;
+    }
+    Entry = &List->Blob[Matched[t]];
+    FromX = Object->X;
+    FromY = Object->Y;
+    Object->VelocityX = Entry->CentroidX - Object->X;
+    Object->VelocityY = Entry->CentroidY - Object->Y;
+    Object->X = Entry->CentroidX;
+    Object->Y = Entry->CentroidY;
+    Object->Area = Entry->Area;
+    Object->Peak = Entry->Peak;
+    Object->Missed = 0;
+    if(Object->Hits < 255) Object->Hits++;
+    if(Confirmed) TrackEmit(Tracker,TrackMove,Object,FromX,FromY);
+    else if(Object->Hits >= Tracker->ConfirmFrames) TrackEmit(Tracker,TrackEnter,Object,Object->StartX,Object->StartY);
+  }
+
+  for(b = 0; b < List->Count; b++)
+  {
+    if(Used & ((uint32_t)1 << b)) continue;
+    for(t = 0; t < MaxTracks && Tracker->Track[t].Id != 0; t++);
+    if(t == MaxTracks) break;
+    Entry = &List->Blob[b];
+    Object = &Tracker->Track[t];
+    memset(Object,0,sizeof(ThermalTrack));
+    Object->Id = Tracker->NextId;
+    Tracker->NextId = Tracker->NextId == 255 ? 1 : Tracker->NextId + 1;
+    Object->Hits = 1;
+    Object->X = Object->StartX = Entry->CentroidX;
+    Object->Y = Object->StartY = Entry->CentroidY;
+    Object->Area = Entry->Area;
+    Object->Peak = Entry->Peak;
+    if(Tracker->ConfirmFrames <= 1) TrackEmit(Tracker,TrackEnter,Object,Object->StartX,Object->StartY);
+  }
+  return 0;
+}
+
+/**********************************************************
+Description: Initialize the line counter.
+Input:       *Counter: Counter to be initialized.
+             X0,Y0,X1,Y1: Two points of the virtual line (unit:1/256 pixel, pixel 
+                          centres at 0,256...1792), e.g. 896,1792,896,0 for a 
+                          doorway between columns 3 and 4 where In counts the
+                          objects walking to the right.
+             Band: Half width of the dead band around the line (unit:1/256 pixel). 
+                   An object must get clear of the band on the other side before 
+                   its crossing is counted, so a person standing on the line is 
+                   not counted again and again, e.g. 128.
+Output:      none
+Return:      none
+Others:      In and Out start at 0, clear them at any time to restart counting.
+**********************************************************/
+void LineCounterInit(LineCounter *Counter,int16_t X0,int16_t Y0,int16_t X1,int16_t Y1,uint16_t Band)
+{
+  int32_t dx = (int32_t)X1 - X0;
+  int32_t dy = (int32_t)Y1 - Y0;
+
+  memset(Counter,0,sizeof(LineCounter));
+  Counter->X0 = X0;
+  Counter->Y0 = Y0;
+  Counter->X1 = X1;
+  Counter->Y1 = Y1;
+  Counter->Band = (int32_t)Band * IntSqrt((uint32_t)(dx * dx + dy * dy));
+}
+
+/**********************************************************
+Description: Count the line crossings of the last tracker update.
+Input:       *Counter: Counter initialized by LineCounterInit().
+             *Tracker: Tracker just updated by ObjectTrackerUpdate().
+Output:      Counter -> In, Counter -> Out
+Return:      Crossings counted in this update
+Others:      Only the events are read, so the cost is a few multiplications per 
+             object. The side of an object is remembered only once it is clear 
+             of the band; a crossing is counted when that side changes.
+**********************************************************/
+uint8_t LineCounterUpdate(LineCounter *Counter,const ObjectTracker *Tracker)
+{
+  const TrackEvent *Event;
+  uint8_t e,k,Slot,Crossings = 0;
+  int8_t Side;
+
+  for(e = 0; e < Tracker->EventCount; e++)
+  {
+    Event = &Tracker->Event[e];
+    Slot = MaxTracks;
+    for(k = 0; k < MaxTracks; k++)
+    {
+      if(Counter->Id[k] == Event->Id) { Slot = k; break; }
+      if(Counter->Id[k] == 0 && Slot == MaxTracks) Slot = k;
+    }
+    if(Slot == MaxTracks) continue;         //Cannot happen while every id has a tracker slot
+    if(Event->Type == TrackExit)
+    {
+      if(Counter->Id[Slot] == Event->Id) Counter->Id[Slot] = 0;
+      continue;
+    }
+    if(Counter->Id[Slot] != Event->Id)
+    {
+      Counter->Id[Slot] = Event->Id;
+      Counter->Side[Slot] = LineSide(Counter,Event->FromX,Event->FromY);
+    }
+    Side = LineSide(Counter,Event->X,Event->Y);
+    if(Side == 0 || Side == Counter->Side[Slot]) continue;
+    if(Counter->Side[Slot] != 0)
+    {
+      if(Side > 0) Counter->In++;
+      else Counter->Out++;
+      Crossings++;
+    }
+    Counter->Side[Slot] = Side;
+  }
+  return Crossings;
+}
+
+/**********************************************************
+Description: Initialize the background model.
+Input:       *Model: Model to be initialized.
+             Rate: Background pixels learn 2^-Rate of their deviation per frame 
+                   (1~15), e.g. 5 follows a slow drift within a few seconds at FPS_10.
+             Sigma: Deviation taken as foreground (unit:1/4 standard deviation, 
+                    1~32), e.g. 12 for 3 standard deviations.
+             MinDeviation: Smallest deviation taken as foreground (unit:0.25℃), 
+                           e.g. 6, keeps a very quiet pixel from flagging noise.
+             Occupied: Foreground pixels that freeze the model (0: never), e.g. 2.
+Output:      none
+Return:      none
+Others:      SlowRate is set to Rate + 4 and MaxFreeze to 600 frames (one minute at
+             FPS_10), both may be changed afterwards. The first frame becomes the
+             background, so start the model on an empty scene if possible.
+**********************************************************/
+void BackgroundModelInit(BackgroundModel *Model,uint8_t Rate,uint8_t Sigma,uint8_t MinDeviation,uint8_t Occupied)
+{
+  memset(Model,0,sizeof(BackgroundModel));
+  Model->Rate = Rate < 1 ? 1 : (Rate > 15 ? 15 : Rate);
+  Model->SlowRate = Model->Rate + 4 > 15 ? 15 : Model->Rate + 4;
+  Model->Sigma = Sigma < 1 ? 1 : (Sigma > 32 ? 32 : Sigma);
+  Model->MinDeviation = MinDeviation;
+  Model->Occupied = Occupied;
+  Model->MaxFreeze = 600;
+}
+
+/**********************************************************
+Description: Separate a frame into background and foreground, then learn it.
+Input:       *Model: Model initialized by BackgroundModelInit().
+             *RawMat: 8*8 frame (unit:0.25℃).
+             *Mask: 64 flags of the previous update (any value the first time).
+Output:      *Mask: 1 for a foreground pixel, 0 for background, e.g. for BlobLabel().
+             Model -> Foreground, Model -> Motion
+Return:      Foreground pixels of the frame
+Others:      A pixel is foreground when it deviates from its mean by at least 
+             MinDeviation and by more than Sigma standard deviations. Each mean and
+             variance is an exponential average updated in place, 2 passes over 
+             the 64 pixels:
+             1. Learning rate: the first frames are averaged (2^-1, 2^-2 ... down 
+                to 2^-Rate), so the model settles quickly after power-on; after
+                that background pixels learn at 2^-Rate, foreground pixels at 
+                the much slower 2^-SlowRate, so a person standing still is not 
+                absorbed while a warm radiator switched on still is, eventually.
+             2. Occupancy: while Occupied or more pixels are foreground nothing
+                is learned, for at most MaxFreeze frames in a row.
+             Deviations beyond 64℃ count as 64℃ in the variance.
+**********************************************************/
+uint8_t BackgroundModelUpdate(BackgroundModel *Model,const int16_t *RawMat,uint8_t *Mask)
+{
+  uint8_t i,Shift,Rate,Flag,Count = 0,Motion = 0;
+  int32_t Deviation,Square;
+  uint32_t Limit;
+
+  if(Model->Frames == 0)
+  {
+    for(i = 0; i < FramePixels; i++)
+    {
+      Model->Mean[i] = (int32_t)RawMat[i] << 8;
+      Model->Variance[i] = 256;              //(0.25℃)^2 until the noise is learned
+      Mask[i] = 0;
+    }
+    Model->Frames = 1;
+    Model->Frozen = 0;
+    Model->Foreground = 0;
+    Model->Motion = 0;
+    return 0;
+  }
+
+  for(i = 0; i < FramePixels; i++)
+  {
+    Deviation = (((int32_t)RawMat[i] << 8) - Model->Mean[i] + 128) >> 8;
+    if(Deviation < 0) Deviation = -Deviation;
+    if(Deviation > 255) Deviation = 255;
+    Limit = (uint32_t)(Model->Variance[i] >> 4) * Model->Sigma * Model->Sigma;
+    Flag = Deviation >= Model->MinDeviation && ((uint32_t)(Deviation * Deviation) << 8) > Limit;
+    Motion += Flag != (Mask[i] != 0);
+    Mask[i] = Flag;
+    Count += Flag;
+  }
+  Model->Foreground = Count;
+  Model->Motion = Motion;
+
+  if(Model->Occupied != 0 && Count >= Model->Occupied)
+  {
+    if(Model->Frozen < Model->MaxFreeze)
+    {
+      Model->Frozen++;
+      return Count;
+    }
+  }
+  else Model->Frozen = 0;
+
+  for(Rate = 1; Rate < Model->Rate && ((uint16_t)1 << Rate) <= Model->Frames; Rate++);
+  for(i = 0; i < FramePixels; i++)
+  {
+    Shift = Rate;
+    if(Mask[i])
+    {
+      if(Model->SlowRate == 0) continue;
+      if(Model->SlowRate > Shift) Shift = Model->SlowRate;
+    }
+    Deviation = ((int32_t)RawMat[i] << 8) - Model->Mean[i];
+    Model->Mean[i] += Deviation >> Shift;
+    Deviation = (Deviation + 128) >> 8;
+    if(Deviation < -255) Deviation = -255;
+    if(Deviation > 255) Deviation = 255;
+    Square = (Deviation * Deviation) << 8;
+    Model->Variance[i] += (Square - Model->Variance[i]) >> Shift;
+  }
+  if(Model->Frames < 0xffff) Model->Frames++;
+  return Count;
+}
+
+/**********************************************************
+Description: Give every pixel of a threshold map the same thresholds.
+Input:       *Map: Map to be initialized.
+             High: Alarm above this temperature (unit:0.25℃), ThresholdHighOff: never.
+             Low: Alarm below this temperature (unit:0.25℃), ThresholdLowOff: never.
+             Hysteresis: Return past the threshold that clears an alarm (unit:0.25℃).
+Output:      none
+Return:      none
+Others:      Change High[] and Low[] of single pixels or zones afterwards.
+**********************************************************/
+void ThresholdMapInit(ThresholdMap *Map,int16_t High,int16_t Low,uint8_t Hysteresis)
+{
+  uint8_t i;
+
+  for(i = 0; i < FramePixels; i++)
+  {
+    Map->High[i] = High;
+    Map->Low[i] = Low;
+  }
+  Map->Hysteresis = Hysteresis;
+  Map->Count = 0;
+  memset(Map->Alarm,0,sizeof(Map->Alarm));
+}
+
+/**********************************************************
+Description: Loosest single band that covers every threshold of the map.
+Input:       *Map: Threshold map.
+Output:      *High: Lowest high threshold less the hysteresis (unit:0.25℃).
+             *Low: Highest low threshold plus the hysteresis (unit:0.25℃).
+Return:      none
+Others:      Programmed as the interrupt levels of the sensor, the band flags every
+             pixel that is, or is still, in alarm under its own threshold, so the
+             map only needs evaluating while the interrupt is asserted.
+**********************************************************/
+void ThresholdMapBand(const ThresholdMap *Map,int16_t *High,int16_t *Low)
+{
+  int16_t MinHigh = ThresholdHighOff,MaxLow = ThresholdLowOff;
+  uint8_t i;
+
+  for(i = 0; i < FramePixels; i++)
+  {
+    if(Map->High[i] < MinHigh) MinHigh = Map->High[i];
+    if(Map->Low[i] > MaxLow) MaxLow = Map->Low[i];
+  }
+  //One step more, whether the sensor compares with > or >=
+  MinHigh = MinHigh - Map->Hysteresis - 1 < ThresholdLowOff ? ThresholdLowOff : MinHigh - Map->Hysteresis - 1;
+  MaxLow = MaxLow + Map->Hysteresis + 1 > ThresholdHighOff ? ThresholdHighOff : MaxLow + Map->Hysteresis + 1;
+  *High = MinHigh;
+  *Low = MaxLow;
+}
+
+/**********************************************************
+Description: Check every pixel against its own thresholds.
+Input:       *Map: Threshold map.
+             *RawMat: 8*8 frame (unit:0.25℃).
+             *IntTable: Optional interrupt table of the sensor (getINTTable()), only
+                        the pixels it flags are checked and the others leave the 
+                        alarm. NULL: check all pixels.
+Output:      Map -> Alarm, Map -> Count
+Return:      Pixels in alarm
+Others:      A pixel enters the alarm above High or below Low, and leaves it once
+             it is back by more than Hysteresis.
+**********************************************************/
+uint8_t ThresholdMapEvaluate(ThresholdMap *Map,const int16_t *RawMat,const uint8_t *IntTable)
+{
+  uint8_t i,Bit,Count = 0;
+  int16_t Value;
+
+  for(i = 0; i < FramePixels; i++)
+  {
+    Bit = 1 << (i & 7);
+    if(IntTable != NULL && (IntTable[i >> 3] & Bit) == 0)
+    {
+      Map->Alarm[i >> 3] &= ~Bit;
+      continue;
+    }
+    Value = RawMat[i];
+    if(Value > Map->High[i] || Value < Map->Low[i]
+       || ((Map->Alarm[i >> 3] & Bit) && (Value > Map->High[i] - Map->Hysteresis || Value < Map->Low[i] + Map->Hysteresis)))
+    {
+      Map->Alarm[i >> 3] |= Bit;
+      Count++;
+    }
+    else Map->Alarm[i >> 3] &= ~Bit;
+  }
+  Map->Count = Count;
+  return Count;
+}
+
+/**********************************************************
+Description: Initialize the rate-of-rise detector.
+Input:       *Detector: Detector to be initialized.
+             *History: Buffer of Window * 64 samples for the history of the 
+                       pixels (2 * 64 bytes per sample), e.g. int16_t History[6][64].
+             SamplePeriod: Frames averaged into one sample (1~16).
+             Window: Samples the rise is fitted over (2~RiseMaxWindow). The window 
+                     spans (Window - 1) * SamplePeriod frames, e.g. Window 6 and 
+                     SamplePeriod 2 for 10s at FPS_1, or Window 8 and SamplePeriod 
+                     14 for about 10s at FPS_10. Window 4 and SamplePeriod 3 span 
+                     9s at FPS_1 with a 512-byte history.
+             RiseOn: Rise over the window that raises an alarm (unit:0.25℃), e.g. 
+                     20 for 5℃ per 10s.
+             RiseOff: Rise below which the alarm clears (unit:0.25℃), less than RiseOn.
+Output:      none
+Return:      none
+Others:      The detector keeps History until it is initialized again, there is 
+             no alarm until Window samples have been gathered.
+**********************************************************/
+void RiseDetectorInit(RiseDetector *Detector,int16_t *History,uint8_t SamplePeriod,uint8_t Window,int16_t RiseOn,int16_t RiseOff)
+{
+  memset(Detector,0,sizeof(RiseDetector));
+  Detector->History = History;
+  Detector->SamplePeriod = SamplePeriod < 1 ? 1 : (SamplePeriod > 16 ? 16 : SamplePeriod);
+  Detector->Window = Window < 2 ? 2 : (Window > RiseMaxWindow ? RiseMaxWindow : Window);
+  Detector->RiseOn = RiseOn;
+  Detector->RiseOff = RiseOff > RiseOn ? RiseOn : RiseOff;
+}
+
+/**********************************************************
+Description: Add a frame and raise or clear the rate-of-rise alarms.
+Input:       *Detector: Detector initialized by RiseDetectorInit().
+             *RawMat: 8*8 frame (unit:0.25℃).
+Output:      Detector -> Alarm, Count, MaxRise, MaxIndex
+Return:      Pixels in alarm
+Others:      Frames are summed per pixel, every SamplePeriod frames the average 
+             becomes a sample and the rise of every pixel is fitted over its 
+             last Window samples by least squares, in integers:
+                 Rise = (Window - 1) * sum(c[j] * x[j]) / (2 * sum(c[j]^2)),  
+                 c[j] = 2 * j - (Window - 1)
+             so one noisy sample moves it little. A pixel enters the alarm at 
+             RiseOn and leaves it below RiseOff. The other frames cost one 
+             addition per pixel.
+**********************************************************/
+uint8_t RiseDetectorUpdate(RiseDetector *Detector,const int16_t *RawMat)
+{
+  uint8_t i,j,Row,Bit,Window,Count = 0;
+  int16_t Weight;
+  int32_t Fit,Norm,Rise;
+
+  for(i = 0; i < FramePixels; i++)
+  {
+    Detector->Sum[i] += RawMat[i];
+  }
+  if(++Detector->Frames < Detector->SamplePeriod)
+  {
+    return Detector->Count;
+  }
+
+  Row = Detector->Head;
+  for(i = 0; i < FramePixels; i++)
+  {
+    Detector->History[Row * FramePixels + i] = (int32_t)Detector->Sum[i] * 4 / Detector->SamplePeriod;
+    Detector->Sum[i] = 0;
+  }
+  Detector->Frames = 0;
+  Window = Detector->Window;
+  Detector->Head = Row + 1 == Window ? 0 : Row + 1;
+  if(Detector->Samples < Window) Detector->Samples++;
+  if(Detector->Samples < Window)
+  {
+    return Detector->Count;
+  }
+
+  Norm = 2 * (int32_t)Window * (Window * Window - 1) / 3;      //2 * sum(c[j]^2)
+  Detector->MaxRise = -32768;
+  for(i = 0; i < FramePixels; i++)
+  {
+    Fit = 0;
+    Row = Detector->Head;          //Oldest sample of the window
+    for(j = 0; j < Window; j++)
+    {
+      Weight = 2 * j - (Window - 1);
+      Fit += (int32_t)Weight * Detector->History[Row * FramePixels + i];
+      Row = Row + 1 == Window ? 0 : Row + 1;
+    }
+    //Slope 2 * Fit / sum(c[j]^2) in 1/16℃ per sample, times Window - 1 samples, in 0.25℃
+    Rise = (int32_t)(Window - 1) * Fit / Norm;
+    if(Rise > Detector->MaxRise)
+    {
+      Detector->MaxRise = Rise;
+      Detector->MaxIndex = i;
+    }
+    Bit = 1 << (i & 7);
+    if(Rise >= Detector->RiseOn || ((Detector->Alarm[i >> 3] & Bit) && Rise >= Detector->RiseOff))
+    {
+      Detector->Alarm[i >> 3] |= Bit;
+      Count++;
+    }
+    else Detector->Alarm[i >> 3] &= ~Bit;
+  }
+  Detector->Count = Count;
+  return Count;
+}
+
+/**********************************************************
+Description: Root of a provisional label.
+Input:       *Parent: Union-find links.
+             Label: Provisional label.
+Output:      none
+Return:      Root label
+Others:      Path halving keeps the chains short.
+**********************************************************/
+static uint8_t BlobFind(uint8_t *Parent,uint8_t Label)
+{
+  while(Parent[Label] != Label)
+  {
+    Parent[Label] = Parent[Parent[Label]];
+    Label = Parent[Label];
+  }
+  return Label;
+}
+
+/**********************************************************
+Description: Add the statistics of one blob to another.
+Input:       *Into: Root that stays.
+             *From: Root that is joined to Into.
+Output:      none
+Return:      none
+Others:      Centroids still hold coordinate sums here.
+**********************************************************/
+static void BlobMerge(ThermalBlob *Into,const ThermalBlob *From)
+{
+  Into->Area += From->Area;
+  if(From->Left < Into->Left) Into->Left = From->Left;
+  if(From->Right > Into->Right) Into->Right = From->Right;
+  if(From->Top < Into->Top) Into->Top = From->Top;
+  if(From->Bottom > Into->Bottom) Into->Bottom = From->Bottom;
+  if(From->Peak > Into->Peak)
+  {
+    Into->Peak = From->Peak;
+    Into->PeakIndex = From->PeakIndex;
+  }
+  Into->CentroidX += From->CentroidX;
+  Into->CentroidY += From->CentroidY;
+}
+
+/**********************************************************
+Description: Append an event to the tracker.
+Input:       *Tracker: Tracker being updated.
+             Type: TrackEnter, TrackMove or TrackExit.
+             *Object: Object of the event.
+             FromX,FromY: Previous or first centroid (unit:1/256 pixel).
+Output:      none
+Return:      none
+Others:      Every slot adds at most one event in the update loop and one when 
+             it is taken by a new object, so Event[] cannot overflow.
+**********************************************************/
+static void TrackEmit(ObjectTracker *Tracker,uint8_t Type,const ThermalTrack *Object,int16_t FromX,int16_t FromY)
+{
+  TrackEvent *Event = &Tracker->Event[Tracker->EventCount++];
+
+  Event->Type = Type;
+  Event->Id = Object->Id;
+  Event->X = Object->X;
+  Event->Y = Object->Y;
+  Event->FromX = FromX;
+  Event->FromY = FromY;
+}
+
+/**********************************************************
+Description: Side of the virtual line a point lies on.
+Input:       *Counter: Line counter.
+             X,Y: Point (unit:1/256 pixel).
+Output:      none
+Return:      1: right-hand side  -1: left-hand side  0: inside the dead band
+Others:      The cross product is the distance to the line times its length, 
+             which Band already includes, so no division is needed.
+**********************************************************/
+static int8_t LineSide(const LineCounter *Counter,int16_t X,int16_t Y)
+{
+  int32_t Cross = ((int32_t)Counter->X1 - Counter->X0) * ((int32_t)Y - Counter->Y0)
+                - ((int32_t)Counter->Y1 - Counter->Y0) * ((int32_t)X - Counter->X0);
+
+  if(Cross > Counter->Band) return 1;
+  if(Cross < -Counter->Band) return -1;
+  return 0;
+}
+
+/**********************************************************
+Description: Integer square root.
+Input:       Value: Radicand.
+Output:      none
+Return:      Largest integer whose square is at most Value
+Others:      Bit by bit, no multiplication.
+**********************************************************/
+static uint16_t IntSqrt(uint32_t Value)
+{
+  uint32_t Root = 0;
+  uint32_t Bit = (uint32_t)1 << 30;
+
+  while(Bit > Value) Bit >>= 2;
+  while(Bit != 0)
+  {
+    if(Value >= Root + Bit)
+    {
+      Value -= Root + Bit;
+      Root = (Root >> 1) + Bit;
+    }
+    else Root >>= 1;
+    Bit >>= 2;
+  }
+  return (uint16_t)Root;
+}
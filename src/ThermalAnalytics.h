@@ -0,0 +1,180 @@
+/*****************************************************************
+File:             ThermalAnalytics.h
+Author:           BESTMODULES
+Description:      Object analysis on the 8*8 frames of the BMS26M833, in integer arithmetic
+                  on the raw pixels of readRawPixelsAndMaximum() (unit:0.25℃).
+History：
+V1.0.1   -- initial version；2026-10-19；Arduino IDE :v1.8.15
+******************************************************************/
+#ifndef _THERMALANALYTICS_H_
+#define _THERMALANALYTICS_H_
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#define FrameWidth     8
+#define FrameHeight    8
+#define FramePixels    64
+#define MaxBlobs       32        //Most separate blobs an 8*8 frame can hold (checkerboard, Neighbors4)
+#define MaxTracks      8         //Objects followed at the same time by ObjectTracker
+#define MaxTrackEvents (MaxTracks * 2)  //Every slot can end one object and start another in one frame
+#define RiseMaxWindow  16        //Most samples RiseDetector fits the rise over
+
+/*Object tracker events*/
+#define TrackEnter     1         //A new object was confirmed
+#define TrackMove      2         //A confirmed object was found again
+#define TrackExit      3         //A confirmed object was not seen for more than MaxMissed frames
+
+/*Thresholds of a pixel that never alarms*/
+#define ThresholdHighOff  2047
+#define ThresholdLowOff   (-2048)
+
+/*Blob connectivity*/
+#ifndef Neighbors4
+#define Neighbors4     4
+#define Neighbors8     8
+#endif
+
+typedef struct
+{
+	uint8_t Area;                  //Pixels of the blob
+	uint8_t Left;                  //Bounding box, columns and rows included (0~7)
+	uint8_t Top;
+	uint8_t Right;
+	uint8_t Bottom;
+	uint8_t PeakIndex;             //Pixel number of the hottest pixel (row * 8 + column)
+	int16_t Peak;                  //Temperature of the hottest pixel (unit:0.25℃)
+	int16_t CentroidX;             //Centre of the blob pixels (unit:1/256 pixel, pixel centres at 0,256...1792)
+	int16_t CentroidY;
+}ThermalBlob;
+
+/*Result of BlobLabel(), also the arena of the labeler: no memory is allocated*/
+typedef struct
+{
+	uint8_t Count;                 //Blobs in Blob[], largest first
+	uint8_t Parent[MaxBlobs];      //Union-find links of the provisional labels
+	ThermalBlob Blob[MaxBlobs];
+}BlobList;
+
+typedef struct
+{
+	uint8_t Id;                    //Object number (1~255), 0: free slot
+	uint8_t Hits;                  //Frames the object was found in, saturates at 255
+	uint8_t Missed;                //Frames since the object was last found
+	uint8_t Area;                  //Area of the last blob
+	int16_t X;                     //Last centroid (unit:1/256 pixel)
+	int16_t Y;
+	int16_t VelocityX;             //Last displacement (unit:1/256 pixel per frame), used to predict the next position
+	int16_t VelocityY;
+	int16_t StartX;                //Centroid when the object was first seen
+	int16_t StartY;
+	int16_t Peak;                  //Temperature of the hottest pixel of the last blob (unit:0.25℃)
+}ThermalTrack;
+
+typedef struct
+{
+	uint8_t Type;                  //TrackEnter, TrackMove or TrackExit
+	uint8_t Id;
+	int16_t X;                     //Enter/Move: current centroid  Exit: last centroid (unit:1/256 pixel)
+	int16_t Y;
+	int16_t FromX;                 //Move: previous centroid  Enter/Exit: centroid when first seen
+	int16_t FromY;
+}TrackEvent;
+
+/*Nearest-neighbour tracker of the blobs of successive frames (see ObjectTrackerUpdate)*/
+typedef struct
+{
+	uint16_t MaxDistance;          //Farthest a blob may be from the predicted position of a track (unit:1/256 pixel)
+	uint8_t ConfirmFrames;         //Frames a new object must be found in before TrackEnter (1: at once)
+	uint8_t MaxMissed;             //Frames an object may be lost before TrackExit
+	uint8_t NextId;
+	uint8_t EventCount;            //Events of the last update
+	ThermalTrack Track[MaxTracks];
+	TrackEvent Event[MaxTrackEvents];
+}ObjectTracker;
+
+/*Counter of the objects that cross a virtual line (see LineCounterUpdate)*/
+typedef struct
+{
+	int16_t X0;                    //Line through (X0,Y0) and (X1,Y1) (unit:1/256 pixel)
+	int16_t Y0;
+	int16_t X1;
+	int16_t Y1;
+	int32_t Band;                  //Half width of the dead band times the line length, in cross-product units
+	uint16_t In;                   //Crossings to the right-hand side looking from (X0,Y0) to (X1,Y1)
+	uint16_t Out;                  //Crossings to the left-hand side
+	uint8_t Id[MaxTracks];         //Objects seen by the counter, 0: free
+	int8_t Side[MaxTracks];        //Side each object was last seen clear of the band: 1 right, -1 left, 0 not yet
+}LineCounter;
+
+/*Per-pixel running background of the scene (see BackgroundModelUpdate)*/
+typedef struct
+{
+	int32_t Mean[FramePixels];     //Background temperature (unit:1/1024℃)
+	int32_t Variance[FramePixels]; //Background noise (unit:1/256 of (0.25℃)^2)
+	uint8_t Rate;                  //Background pixels learn 2^-Rate of their deviation per frame (1~15)
+	uint8_t SlowRate;              //Foreground pixels learn 2^-SlowRate per frame, 0: not at all
+	uint8_t Sigma;                 //Deviation taken as foreground (unit:1/4 standard deviation, 1~32)
+	uint8_t MinDeviation;          //Smallest deviation taken as foreground (unit:0.25℃)
+	uint8_t Occupied;              //Foreground pixels that freeze the model, 0: never frozen
+	uint16_t MaxFreeze;            //Frames the model stays frozen at most, then it absorbs the scene
+	uint16_t Frozen;               //Frames frozen in a row
+	uint16_t Frames;               //Frames learned, saturates at 65535
+	uint8_t Foreground;            //Foreground pixels of the last update
+	uint8_t Motion;                //Pixels that changed between background and foreground in the last update
+}BackgroundModel;
+
+/*Alarm threshold of every pixel (see ThresholdMapEvaluate)*/
+typedef struct
+{
+	int16_t High[FramePixels];     //A pixel alarms above its High (unit:0.25℃), ThresholdHighOff: never
+	int16_t Low[FramePixels];      //A pixel alarms below its Low (unit:0.25℃), ThresholdLowOff: never
+	uint8_t Hysteresis;            //Return past the threshold that clears an alarm (unit:0.25℃)
+	uint8_t Count;                 //Pixels in alarm
+	uint8_t Alarm[8];              //Pixels in alarm, one bit per pixel laid out as getINTTable()
+}ThresholdMap;
+
+/*Rate-of-rise detector (see RiseDetectorUpdate)*/
+typedef struct
+{
+	int16_t *History;              //Last Window samples of every pixel, a ring of Window rows of 64 given by the caller (unit:1/16℃)
+	int16_t Sum[FramePixels];      //Frames of the sample being gathered (unit:0.25℃)
+	uint8_t SamplePeriod;          //Frames averaged into one sample (1~16)
+	uint8_t Window;                //Samples the rise is fitted over (2~RiseMaxWindow), also the rows of History
+	int16_t RiseOn;                //Rise over the window that raises an alarm (unit:0.25℃)
+	int16_t RiseOff;               //Rise below which an alarm clears (unit:0.25℃)
+	uint8_t Frames;                //Frames in Sum
+	uint8_t Head;                  //Next row of History
+	uint8_t Samples;               //Rows of History filled, up to Window
+	uint8_t Count;                 //Pixels in alarm
+	uint8_t Alarm[8];              //Pixels in alarm, one bit per pixel laid out as getINTTable()
+	int16_t MaxRise;               //Largest rise of the last fit (unit:0.25℃)
+	uint8_t MaxIndex;              //Pixel of MaxRise
+}RiseDetector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t BlobLabel(const int16_t *RawMat,const uint8_t *Mask,int16_t Threshold,uint8_t Neighbors,uint8_t MinArea,BlobList *List);
+void ObjectTrackerInit(ObjectTracker *Tracker,uint16_t MaxDistance,uint8_t ConfirmFrames,uint8_t MaxMissed);
+uint8_t ObjectTrackerUpdate(ObjectTracker *Tracker,const BlobList *List);
+void LineCounterInit(LineCounter *Counter,int16_t X0,int16_t Y0,int16_t X1,int16_t Y1,uint16_t Band);
+uint8_t LineCounterUpdate(LineCounter *Counter,const ObjectTracker *Tracker);
+void BackgroundModelInit(BackgroundModel *Model,uint8_t Rate,uint8_t Sigma,uint8_t MinDeviation,uint8_t Occupied);
+uint8_t BackgroundModelUpdate(BackgroundModel *Model,const int16_t *RawMat,uint8_t *Mask);
+void ThresholdMapInit(ThresholdMap *Map,int16_t High,int16_t Low,uint8_t Hysteresis);
+void ThresholdMapBand(const ThresholdMap *Map,int16_t *High,int16_t *Low);
+uint8_t ThresholdMapEvaluate(ThresholdMap *Map,const int16_t *RawMat,const uint8_t *IntTable);
+void RiseDetectorInit(RiseDetector *Detector,int16_t *History,uint8_t SamplePeriod,uint8_t Window,int16_t RiseOn,int16_t RiseOff);
+uint8_t RiseDetectorUpdate(RiseDetector *Detector,const int16_t *RawMat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif